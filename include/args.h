@@ -17,7 +17,13 @@ namespace ante {
         Help,
         Lib,
         EmitLLVM,
-        NoColor
+        NoColor,
+        CodegenThreads,
+        Incremental,
+        ThinLTO,
+        ProfileGenerate,
+        ProfileUse,
+        JITCache
     };
 
     struct Argument {
@@ -31,6 +37,9 @@ namespace ante {
         std::vector<std::unique_ptr<Argument>> args;
         std::vector<std::string> inputFiles;
 
+        /** Bitcode files (eg. from clang -flto=thin) to link with when using ThinLTO */
+        std::vector<std::string> bitcodeFiles;
+
         void addArg(Argument *a);
         bool hasArg(Args a) const;
         Argument* getArg(Args a) const;
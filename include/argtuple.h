@@ -1,6 +1,8 @@
 #ifndef AN_ARGTUPLE_H
 #define AN_ARGTUPLE_H
 
+#include <cassert>
+#include <type_traits>
 #include "compiler.h"
 
 namespace ante {
@@ -57,6 +59,9 @@ namespace ante {
             /** Stores a primitive floating-point value. */
             void storeFloat(Compiler *c, TypedValue const& tv);
 
+            /** Stores a constant union with a niche layout. */
+            void storeUnion(Compiler *c, TypedValue const& tv);
+
             /**
              * Converts the given TypedValue into its corresponding
              * value in c++ and stores it in this->data
@@ -65,35 +70,84 @@ namespace ante {
     };
 
 
+    namespace ctfunc {
+        template<size_t... Is> struct IndexSeq {};
+
+        template<size_t N, size_t... Is>
+        struct MakeIndexSeq : MakeIndexSeq<N-1, N-1, Is...> {};
+
+        template<size_t... Is>
+        struct MakeIndexSeq<0, Is...> { using type = IndexSeq<Is...>; };
+
+        /** Calls f, forwarding each TypedValue in args as a separate argument */
+        template<typename Ret>
+        struct Call {
+            template<typename... Args, size_t... Is>
+            static TypedValue call(Ret(*f)(Compiler*, Args...), Compiler *c,
+                    std::vector<TypedValue> const& args, IndexSeq<Is...>){
+                return f(c, args[Is]...);
+            }
+        };
+
+        /** void-returning api functions return a void literal */
+        template<>
+        struct Call<void> {
+            template<typename... Args, size_t... Is>
+            static TypedValue call(void(*f)(Compiler*, Args...), Compiler *c,
+                    std::vector<TypedValue> const& args, IndexSeq<Is...>){
+                f(c, args[Is]...);
+                return c->getVoidLiteral();
+            }
+        };
+    }
+
+
     /**
      * Holds a c++ function.
      *
      * Used to represent compiler API functions and call them
-     * with compile-time constants as arguments
+     * with compile-time constants as arguments.
+     *
+     * An api function must take a Compiler* followed by any number of
+     * TypedValues and return either a TypedValue or void.  The CtFunc
+     * constructor generates the invoker to call it from its signature.
      */
     struct CtFunc {
-        void *fn;
+        using RawFn = void(*)();
+        using Invoker = TypedValue(*)(RawFn, Compiler*, std::vector<TypedValue> const&);
+
+        RawFn fn;
+        Invoker invoker;
         std::vector<AnType*> params;
         AnType* retty;
 
-        size_t numParams() const { return params.size(); }
-        bool typeCheck(std::vector<AnType*> &args);
-        bool typeCheck(std::vector<TypedValue&> &args);
-        CtFunc(void* fn);
-        CtFunc(void* fn, AnType *retTy);
-        CtFunc(void* fn, AnType *retTy, std::vector<AnType*> params);
+        template<typename Ret, typename... Args>
+        CtFunc(Ret(*f)(Compiler*, Args...), AnType *retTy, std::vector<AnType*> p = {}) :
+            fn(reinterpret_cast<RawFn>(f)), invoker(&invoke<Ret, Args...>), params(p), retty(retTy){
+
+            static_assert(std::is_same<Ret, TypedValue>::value or std::is_void<Ret>::value,
+                    "Compiler api functions must return a TypedValue or void");
+
+            //the invoker reads one argument for each parameter of f
+            assert(params.size() == sizeof...(Args) && "CtFunc registered with the wrong number of params");
+        }
 
         ~CtFunc(){}
 
-        using Arg = TypedValue const&;
+        size_t numParams() const { return params.size(); }
+
+        /** Calls the function with the given arguments.
+         *  Assumes args.size() == numParams() */
+        TypedValue operator()(Compiler *c, std::vector<TypedValue> const& args){
+            return invoker(fn, c, args);
+        }
 
-        TypedValue* operator()(Compiler *c);
-        TypedValue* operator()(Compiler *c, Arg tv);
-        TypedValue* operator()(Compiler *c, Arg tv1, Arg tv2);
-        TypedValue* operator()(Compiler *c, Arg tv1, Arg tv2, Arg tv3);
-        TypedValue* operator()(Compiler *c, Arg tv1, Arg tv2, Arg tv3, Arg tv4);
-        TypedValue* operator()(Compiler *c, Arg tv1, Arg tv2, Arg tv3, Arg tv4, Arg tv5);
-        TypedValue* operator()(Compiler *c, Arg tv1, Arg tv2, Arg tv3, Arg tv4, Arg tv5, Arg tv6);
+        private:
+        template<typename Ret, typename... Args>
+        static TypedValue invoke(RawFn fn, Compiler *c, std::vector<TypedValue> const& args){
+            auto f = reinterpret_cast<Ret(*)(Compiler*, Args...)>(fn);
+            return ctfunc::Call<Ret>::call(f, c, args, typename ctfunc::MakeIndexSeq<sizeof...(Args)>::type());
+        }
     };
 
     extern std::map<std::string, std::unique_ptr<ante::CtFunc>> compapi;
@@ -301,12 +301,42 @@ namespace ante {
          */
         llvm::StringMap<std::shared_ptr<Trait>> traits;
 
+        /**
+         * @brief The module this is a copy-on-write view of, or nullptr.
+         *
+         * Views are used by the Compilers created for compile-time calls.
+         * Anything not found within the view is looked up in its parent and
+         * FuncDecls are only copied into the view once they are used.
+         */
+        const Module *parent = nullptr;
+
+        Module(){}
+
+        /** @brief Creates an empty copy-on-write view of parent */
+        explicit Module(const Module *parent) : name(parent->name), parent(parent){}
+
         /**
         * @brief Merges two modules
         *
         * @param m module to merge into this
         */
         void import(Module *m);
+
+        /**
+         * @brief Returns the mutable list of FuncDecls of the given name.
+         *
+         * If this is a view and the list has not been used yet, the parent's
+         * FuncDecls are first copied so that compiling them does not mark
+         * them as compiled within the parent.
+         */
+        std::vector<std::shared_ptr<FuncDecl>>& getFnDecls(llvm::StringRef name);
+
+        /** @brief Returns the FuncDecls of the given name without copying them, or nullptr. */
+        const std::vector<std::shared_ptr<FuncDecl>>* findFnDecls(llvm::StringRef name) const;
+
+        AnDataType* lookupType(llvm::StringRef name) const;
+
+        Trait* lookupTrait(llvm::StringRef name) const;
     };
 
     /**
@@ -333,6 +363,33 @@ namespace ante {
         CompilerCtxt() : callStack(), obj(0), continueLabels(new std::vector<llvm::BasicBlock*>()), breakLabels(new std::vector<llvm::BasicBlock*>()){}
     };
 
+    class JIT;
+
+    /**
+     * @brief A compiled AnteCall driver for a compile-time function along
+     * with the return type of the function it calls.
+     */
+    struct CtCallDriver {
+        /** Calls the function with the packed arguments in the first parameter (if packArgs)
+         *  and stores the result in the buffer given as the second parameter. */
+        void (*fn)(void*, void*);
+        AnType *retTy;
+
+        /** Size in bytes of the buffer needed to hold the result */
+        size_t retSize;
+
+        /** True if the arguments must be packed into an ArgTuple to be passed to fn */
+        bool packArgs;
+
+        /** True if the driver is only valid for a single call and is freed once run */
+        bool temporary;
+
+        /** If non-null, fn is null and the driver is instead run by this
+         *  interpreter by calling interpretedFn */
+        llvm::ExecutionEngine *interpreter;
+        llvm::Function *interpretedFn;
+    };
+
     /**
      * @brief Contains compile-time information for user hooks and ctStores.
      */
@@ -346,6 +403,31 @@ namespace ante {
         /** @brief arguments to current ante function being called.
          * Will be empty if !isJIT */
         std::vector<TypedValue> args;
+
+        /** @brief JIT shared by every compile-time call made during this
+         * compilation.  Created by the first compile-time call. */
+        std::unique_ptr<JIT> jit;
+
+        /** @brief Directory objects compiled by the JIT are cached in
+         * across runs, given by -jit-cache=.  Nothing is cached if empty. */
+        std::string jitCacheDir;
+
+        /** @brief Drivers of each compile-time call already compiled into jit.
+         * See getCtCallKey in operator.cpp for the key used. */
+        llvm::StringMap<CtCallDriver> ctCallDrivers;
+
+        /** @brief Number of compile-time calls evaluated so far */
+        size_t ctCallsEvaluated = 0;
+
+        /** @brief Interpreters running the drivers of small compile-time functions */
+        std::vector<std::unique_ptr<llvm::ExecutionEngine>> interpreters;
+
+        /** @brief Results of each call to a !pure compile-time function,
+         * keyed by the function and a structural encoding of its arguments. */
+        llvm::StringMap<TypedValue> pureCallResults;
+
+        CompilerCtCtxt();
+        ~CompilerCtCtxt();
     };
 
     /**
@@ -353,7 +435,6 @@ namespace ante {
      */
     struct Compiler {
         std::shared_ptr<llvm::LLVMContext> ctxt;
-        std::unique_ptr<llvm::ExecutionEngine> jit;
         std::unique_ptr<llvm::Module> module;
         std::unique_ptr<parser::RootNode> ast;
         llvm::IRBuilder<> builder;
@@ -383,9 +464,28 @@ namespace ante {
         std::vector<std::string> relativeRoots;
 
         bool errFlag, compiled, isLib, isJIT;
+
+        /** True if each ante::Module should be emitted as its own cached object file */
+        bool isIncremental;
+
+        /** True if the program should be linked using ThinLTO */
+        bool useThinLTO;
+
+        /** Additional bitcode files to link with when using ThinLTO */
+        std::vector<std::string> bitcodeFiles;
+
+        /** True if the output should be instrumented to generate a profile */
+        bool profileGenerate;
+
+        /** Path to the .profdata file to optimize with, empty if there is none */
+        std::string profileUseFile;
         std::string fileName, outFile, funcPrefix;
         unsigned int scope, optLvl, fnScope;
 
+        /** Number of partitions the module is split into during
+         *  code generation, each compiled on its own thread. */
+        unsigned int codegenThreads;
+
         /**
         * @brief The main constructor for Compiler
         *
@@ -763,6 +863,48 @@ namespace ante {
         */
         int compileIRtoObj(llvm::Module *mod, std::string outFile);
 
+        /**
+        * @brief Compiles a module into one or more obj files, splitting the module
+        *        into codegenThreads partitions that are compiled in parallel.
+        *
+        * @param mod The already-compiled module.  It is not modified.
+        * @param outFile Name of the file to output.  If the module is split, each
+        *        partition is output to outFile with the partition number appended.
+        * @param objFiles Filled with the name of each obj file output
+        *
+        * @return 0 on success
+        */
+        int compileIRtoObjs(llvm::Module *mod, std::string outFile, std::vector<std::string> &objFiles);
+
+        /**
+        * @brief Compiles a module into one obj file per ante::Module it contains code from.
+        *        Each object is stored in a cache keyed by the hash of its IR and code
+        *        generation is skipped if an object with the same hash is already cached.
+        *        The whole program is still parsed and lowered to IR on every build.
+        *        Defined in incremental.cpp
+        *
+        * @param mod The already-compiled module.  It is not modified.
+        * @param objFiles Filled with the path of each cached obj file
+        *
+        * @return 0 on success
+        */
+        int compileModulesToObjs(llvm::Module *mod, std::vector<std::string> &objFiles);
+
+        /**
+        * @brief Compiles a module along with the given bitcode files using ThinLTO.
+        *        Each ante::Module and bitcode file is summarized and optimized in
+        *        parallel across codegenThreads backends.  Defined in lto.cpp
+        *
+        * @param mod The already-compiled module.  It is not modified.
+        * @param bitcodeFiles Paths of additional bitcode files to include
+        * @param outFile Prefix of the name of each obj file to output
+        * @param objFiles Filled with the name of each obj file output
+        *
+        * @return 0 on success
+        */
+        int compileWithThinLTO(llvm::Module *mod, std::vector<std::string> const& bitcodeFiles,
+                std::string outFile, std::vector<std::string> &objFiles);
+
         TypedValue getVoidLiteral();
 
         /**
@@ -790,6 +932,14 @@ namespace ante {
     */
     extern std::vector<std::unique_ptr<Module>> allMergedCompUnits;
 
+    /**
+    * @brief Splits a copy of the given module into one module per ante::Module
+    * that defined code within it.  Code without a module (main, lambdas, and
+    * generic instantiations) is placed in the first partition.
+    * Defined in incremental.cpp
+    */
+    std::vector<std::unique_ptr<llvm::Module>> splitByAnteModule(Compiler *c, llvm::Module *mod);
+
     /*
      * @brief Compiles and returns the address of an lval or expression
      */
@@ -2,6 +2,7 @@
 #define AN_JIT_H
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
 #include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
@@ -20,10 +21,16 @@
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "objectcache.h"
+
 namespace ante {
     
     class JIT {
@@ -31,6 +38,12 @@ namespace ante {
             std::unique_ptr<llvm::TargetMachine> tm;
             const llvm::DataLayout dl;
             llvm::orc::RTDyldObjectLinkingLayer objectLayer;
+
+            /** Caches of the objects compiled at -O0 and -O2 respectively.
+             *  Both are null unless a cache directory was given. */
+            std::unique_ptr<JITObjectCache> baseCache;
+            std::unique_ptr<JITObjectCache> optCache;
+
             llvm::orc::IRCompileLayer<decltype(objectLayer), llvm::orc::SimpleCompiler> compileLayer;
 
             using OptimizeFunction =
@@ -43,12 +56,89 @@ namespace ante {
 
             std::shared_ptr<llvm::Module> optimizeModule(std::shared_ptr<llvm::Module> m);
 
+            /** Suffixes given to the renamed definitions of each module by prepareModule */
+            llvm::StringSet<> usedSuffixes;
+
+            using ObjectPtr = std::shared_ptr<llvm::object::OwningBinary<llvm::object::ObjectFile>>;
+
+            /** An -O2 recompilation of a hot function, waiting to be linked in */
+            struct OptimizedFunction {
+                std::string name;
+                ObjectPtr obj;
+            };
+
+            /** Bitcode of the partition of each function compiled at -O0 before
+             *  it was instrumented, for recompiling it at -O2 once it is hot.
+             *  Entries are dropped once the function is optimized or removed. */
+            llvm::StringMap<std::string> tieredFns;
+
+            /** Objects linked in by linkOptimizedFunctions, by the name of the
+             *  function they optimize.  Only accessed from the main thread. */
+            llvm::StringMap<decltype(objectLayer)::ObjHandleT> optimizedObjects;
+
+            /** A module added with addTemporaryModule and the functions it defines */
+            struct TemporaryModule {
+                decltype(codLayer)::ModuleHandleT handle;
+                std::vector<std::string> fns;
+            };
+
+            /** Modules added with addTemporaryModule that have not been removed yet */
+            std::vector<TemporaryModule> temporaryModules;
+
+            /** TargetMachine used by the background thread at -O2 */
+            std::unique_ptr<llvm::TargetMachine> optTm;
+
+            /** Guards tieredFns, hotFns, optimizedFns, and stopping */
+            std::mutex tierMutex;
+            std::condition_variable tierCv;
+            std::deque<std::string> hotFns;
+            std::vector<OptimizedFunction> optimizedFns;
+            bool stopping = false;
+            std::thread optimizer;
+
+            std::shared_ptr<llvm::JITSymbolResolver> createResolver();
+
+            /** Returns name as it appears in the symbol table of an object */
+            std::string mangle(const std::string &name) const;
+
+            /**
+             * Moves the definition of g into a permanent module of its own, leaving a
+             * declaration in its place, so that process-wide variables such as those
+             * created by Ante.global outlive the temporary module that first defined them.
+             * Returns false if g's initializer refers to other values in its module.
+             */
+            bool hoistGlobal(llvm::GlobalVariable &g);
+
+            /** Adds a call counter to the function of a partition module */
+            void instrument(llvm::Function &f);
+
+            /** Called from instrumented functions once they become hot */
+            static void onHotFunction(JIT *jit, const char *name);
+
+            /** Recompiles each hot function at -O2, run on the optimizer thread */
+            void optimizeHotFunctions();
+
+            /** Points the stubs of each function optimized so far to their optimized bodies.
+             * Layers are not thread safe so this is only ever done on the main thread, and
+             * never from within JIT-compiled code, ie. only from addModule and getSymbolAddress. */
+            void linkOptimizedFunctions();
+
         public:
             using ModuleHandle = decltype(codLayer)::ModuleHandleT;
 
-            JIT() : tm(llvm::EngineBuilder().selectTarget()), dl(tm->createDataLayout()),
+            /**
+             * Number of calls after which a function compiled at -O0
+             * is recompiled at -O2 on a background thread.
+             */
+            static const uint64_t hotCallThreshold = 1000;
+
+            /** @param cacheDir directory to cache compiled objects in, or empty for none */
+            JIT(std::string const& cacheDir) : tm(llvm::EngineBuilder().setOptLevel(llvm::CodeGenOpt::None).selectTarget()),
+                    dl(tm->createDataLayout()),
                     objectLayer([](){ return std::make_shared<llvm::SectionMemoryManager>(); }),
-                    compileLayer(objectLayer, llvm::orc::SimpleCompiler(*tm)),
+                    baseCache(cacheDir.empty() ? nullptr : new JITObjectCache(cacheDir, 0)),
+                    optCache(cacheDir.empty() ? nullptr : new JITObjectCache(cacheDir, 2)),
+                    compileLayer(objectLayer, llvm::orc::SimpleCompiler(*tm, baseCache.get())),
                     optimizeLayer(compileLayer, [this](std::shared_ptr<llvm::Module> m){
                                 return optimizeModule(std::move(m));
                     }),
@@ -61,12 +151,18 @@ namespace ante {
                                 return std::set<llvm::Function*>({&f});
                             },
                             *compileCallbackManager,
-                            llvm::orc::createLocalIndirectStubsManagerBuilder(tm->getTargetTriple())){
-                        
+                            llvm::orc::createLocalIndirectStubsManagerBuilder(tm->getTargetTriple())),
+                    optTm(llvm::EngineBuilder().setOptLevel(llvm::CodeGenOpt::Default).selectTarget()){
+
+                        //Code is first compiled quickly and only optimized once it is hot
+                        tm->setFastISel(true);
+
                         //pass a nullptr to load the current process
                         llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
                     }
 
+            ~JIT();
+
             void doNothing() const {}
 
             static void handleUnrecognizedFn();
@@ -80,6 +176,28 @@ namespace ante {
             llvm::JITTargetAddress getSymbolAddress(const std::string name);
 
             void removeModule(JIT::ModuleHandle h);
+
+            /**
+             * Prepares m to be added alongside the modules already in this JIT.
+             *
+             * The specialized definitions, eg. the driver of a compile-time call,
+             * are renamed so they cannot clash with any other module's.  Every
+             * other definition already compiled by a previous module becomes a
+             * declaration of it, so each function is only compiled once.
+             * Definitions new to this JIT keep their names so later modules can
+             * link against them, unless m is temporary, in which case they are
+             * renamed as well since m will be removed once it has been run.
+             * Global variables of a temporary module are moved to a permanent
+             * module of their own instead, see hoistGlobal.
+             */
+            void prepareModule(llvm::Module &m, llvm::ArrayRef<llvm::GlobalValue*> specialized, bool temporary);
+
+            /** Adds a module to be removed by the next call to removeTemporaryModules */
+            JIT::ModuleHandle addTemporaryModule(std::unique_ptr<llvm::Module> m);
+
+            /** Removes each temporary module along with the tiering state
+             *  and optimized objects of the functions it defined */
+            void removeTemporaryModules();
     };
 }
 
@@ -0,0 +1,51 @@
+#ifndef AN_OBJECTCACHE_H
+#define AN_OBJECTCACHE_H
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <string>
+
+namespace ante {
+
+    /**
+     * Returns a hash of everything affecting the object code generated for mod.
+     */
+    std::string hashPartition(const llvm::Module *mod, unsigned int optLvl, llvm::StringRef triple);
+
+    /**
+     * Marks a cached object as recently used so pruneCacheDir keeps it.
+     */
+    void touchCachedObject(llvm::StringRef file);
+
+    /**
+     * Removes the least recently used objects within dir until
+     * the objects remaining total at most maxBytes.
+     */
+    void pruneCacheDir(llvm::StringRef dir, uint64_t maxBytes);
+
+    /**
+     * Caches the objects compiled by the JIT within the directory given
+     * by -jit-cache=, keyed by the hash of each module's bitcode, target,
+     * and optimization level, so that identical modules are never compiled
+     * twice even across separate runs of the compiler.  The directory is
+     * pruned to AN_CACHE_MAX_SIZE when the cache is destroyed.
+     */
+    class JITObjectCache : public llvm::ObjectCache {
+        std::string dir;
+        unsigned int optLvl;
+        bool objectsAdded = false;
+
+        std::string getCacheFile(const llvm::Module *m) const;
+
+        public:
+            JITObjectCache(std::string const& dir, unsigned int optLvl) : dir(dir), optLvl(optLvl){}
+            ~JITObjectCache();
+
+            void notifyObjectCompiled(const llvm::Module *m, llvm::MemoryBufferRef obj) override;
+
+            std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *m) override;
+    };
+}
+
+#endif
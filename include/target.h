@@ -141,6 +141,21 @@
 #  define AN_EXEC_STR "./"
 #endif
 
+//Runtime linked into binaries compiled with -fprofile-generate
+#ifndef AN_PROFILE_RT
+#  define AN_PROFILE_RT "`clang --print-file-name=libclang_rt.profile-" AN_NATIVE_ARCH ".a`"
+#endif
+
+//Directory of objects cached by -incremental
+#ifndef AN_CACHE_DIR
+#  define AN_CACHE_DIR ".antcache"
+#endif
+
+//Size in bytes the objects of each cache directory are pruned down to
+#ifndef AN_CACHE_MAX_SIZE
+#  define AN_CACHE_MAX_SIZE (512ull * 1024 * 1024)
+#endif
+
 
 #ifndef AN_TARGET_TRIPLE
 #  define AN_TARGET_TRIPLE AN_NATIVE_ARCH "-" AN_NATIVE_VENDOR "-" AN_NATIVE_OS
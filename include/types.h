@@ -49,6 +49,44 @@ namespace ante {
     std::string getCastFnBaseName(AnType *t);
 
     AnType* getLargestExt(Compiler *c, AnDataType *tn, bool force = false);
+
+    /** @brief How the variants of a tagged union are told apart in memory */
+    enum class UnionLayout {
+        /** The tag followed by storage for the largest variant */
+        Tagged,
+
+        /** One empty variant and one bool variant stored as a byte,
+         *  the empty variant being the otherwise invalid value 2 */
+        Bool,
+    };
+
+    /**
+     * Returns how the given union's variants are told apart.  Only unions
+     * with exactly two variants, one empty and one bool, use a niche layout.
+     * Pointers may be null so they have no value to spare for the empty variant.
+     */
+    UnionLayout getUnionLayout(const AnDataType *unionTy);
+    AnType* getUnionPayloadType(const AnDataType *unionTy, unsigned short tag);
+
+    /** Returns the tag of the empty variant of a union with a Bool layout */
+    unsigned short getNicheEmptyTag(const AnDataType *unionTy);
+
+    /** Returns the type of the tag of the given union, or of the
+     *  tag returned by extractUnionTag if the tag is not stored */
+    llvm::Type* getUnionTagType(Compiler *c, const AnDataType *unionTy);
+
+    llvm::Value* extractUnionTag(Compiler *c, TypedValue const& unionVal);
+
+    /** Creates a value of the given union type from the tag of one of
+     *  its variants and the variant's contents, which may be void */
+    TypedValue createUnionValue(Compiler *c, AnDataType *unionTy, unsigned short tag,
+            TypedValue const& payload, bool force = false);
+
+    /**
+     * Loads the value stored in alloca, which holds a value of the same type as ty
+     * before any of its type variables were bound, as a value of type ty.
+     */
+    llvm::Value* loadAsType(Compiler *c, llvm::Value *alloca, AnType *ty);
     char getBitWidthOfTypeTag(const TypeTag tagTy);
     bool isPrimitiveTypeTag(TypeTag ty);
     bool isNumericTypeTag(const TypeTag ty);
@@ -53,7 +53,13 @@ void printHelp(){
     puts("\t-o <filename>\tspecify output name");
     puts("\t-p\t\tprint parse tree");
     puts("\t-O <number>\tSet optimization level. Arg of 0 = none, 3 = all");
+    puts("\t-j <number>\tSplit code generation across the given number of threads");
     puts("\t-r\t\tcompile and run");
+    puts("\t-incremental\temit an object file per module and skip codegen for those cached in .antcache/");
+    puts("\t-flto=thin\tlink with ThinLTO, any .bc inputs are included in the link");
+    puts("\t-fprofile-generate\tinstrument the output to write a profile to default.profraw when run");
+    puts("\t-fprofile-use=<file>\toptimize using a profile merged with llvm-profdata");
+    puts("\t-jit-cache=<dir>\treuse code compiled for compile-time calls across runs from <dir>");
     puts("\t-help\t\tprint this message");
     puts("\t-lib\t\tcompile as library (include all functions in binary and compile to object file)");
     puts("\t-emit-llvm\tprint llvm-IR as output");
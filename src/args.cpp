@@ -16,7 +16,13 @@ map<string, Args> argsMap = {
     {"-help",      Args::Help},
     {"-lib",       Args::Lib},
     {"-emit-llvm", Args::EmitLLVM},
-    {"-no-color",  Args::NoColor}
+    {"-no-color",  Args::NoColor},
+    {"-j",         Args::CodegenThreads},
+    {"-incremental", Args::Incremental},
+    {"-flto=thin", Args::ThinLTO},
+    {"-fprofile-generate", Args::ProfileGenerate},
+    {"-fprofile-use=", Args::ProfileUse},
+    {"-jit-cache=", Args::JITCache}
 };
 
 void CompilerArgs::addArg(Argument *a){
@@ -48,10 +54,10 @@ bool CompilerArgs::empty() const{
 enum ArgTy { None, Str, Int };
 
 ArgTy requiresArg(Args a){
-    if(a == OutputName)
+    if(a == OutputName or a == ProfileUse or a == JITCache)
         return ArgTy::Str;
 
-    if(a == OptLvl)
+    if(a == OptLvl or a == CodegenThreads)
         return ArgTy::Int;
 
     return ArgTy::None;
@@ -70,6 +76,20 @@ CompilerArgs* ante::parseArgs(int argc, const char** argv){
     for(int i = 1; i < argc; i++){
         if(argv[i][0] == '-'){
             try{
+                //options of the form -opt=<arg> are keyed by everything up to and including the '='
+                string opt = argv[i];
+                size_t eq = opt.find('=');
+                if(eq != string::npos and (eq + 1 == opt.size() or !argsMap.count(opt))){
+                    Args a = argsMap.at(opt.substr(0, eq + 1));
+                    string s = opt.substr(eq + 1);
+                    if(s.empty()){
+                        cerr << "Argument '" << opt << "' requires a " << argTyToStr(requiresArg(a)) << " parameter after the '='.\n";
+                        exit(1);
+                    }
+                    ret->addArg(new Argument(a, s));
+                    continue;
+                }
+
                 Args a = argsMap.at(argv[i]);
                 string s = "";
 
@@ -94,9 +114,19 @@ CompilerArgs* ante::parseArgs(int argc, const char** argv){
         //if it is not an option denoted by '-' it is an input file
         //options requiring their own arguments are already taken care of
         }else{
-            ret->inputFiles.push_back(argv[i]);
+            string file = argv[i];
+            if(file.size() > 3 and file.substr(file.size() - 3) == ".bc")
+                ret->bitcodeFiles.push_back(file);
+            else
+                ret->inputFiles.push_back(file);
         }
     }
+
+    //bitcode is only linked in by ThinLTO, never silently drop it otherwise
+    if(!ret->bitcodeFiles.empty() and !ret->hasArg(Args::ThinLTO)){
+        cerr << "Ante: bitcode file '" << ret->bitcodeFiles[0] << "' can only be linked with -flto=thin\n";
+        exit(1);
+    }
     return ret;
 }
 
@@ -77,6 +77,30 @@ namespace ante {
     }
 
 
+    TypedValue convertUnionToTypedValue(Compiler *c, ArgTuple &arg, AnDataType *unionTy){
+        char *data = (char*)arg.asRawData();
+        auto layout = getUnionLayout(unionTy);
+
+        unsigned short tag;
+        size_t payloadOffset = 0;
+
+        if(layout == UnionLayout::Bool){
+            unsigned short emptyTag = getNicheEmptyTag(unionTy);
+            tag = *(uint8_t*)data == 2 ? emptyTag : 1 - emptyTag;
+        }else{
+            payloadOffset = getUnionTagType(c, unionTy)->getIntegerBitWidth() / 8;
+            tag = payloadOffset == 1 ? *(uint8_t*)data : *(uint16_t*)data;
+        }
+
+        AnType *payloadTy = getUnionPayloadType(unionTy, tag);
+        if(payloadTy->typeTag == TT_Void)
+            return createUnionValue(c, unionTy, tag, c->getVoidLiteral());
+
+        ArgTuple payload{c, (void*)(data + payloadOffset), payloadTy};
+        return createUnionValue(c, unionTy, tag, payload.asTypedValue());
+    }
+
+
     /**
      * Finds and returns the last stored value from a LoadInst
      * of a mutable variable.
@@ -139,9 +163,10 @@ namespace ante {
             case TT_Data:
             case TT_Tuple:
                 return convertTupleToTypedValue(c, arg, (AnAggregateType*)tn);
+            case TT_TaggedUnion:
+                return convertUnionToTypedValue(c, arg, (AnDataType*)tn);
             case TT_TypeVar:
             case TT_Function:
-            case TT_TaggedUnion:
             case TT_MetaFunction:
             case TT_FunctionList:
             case TT_Type:
@@ -320,6 +345,19 @@ namespace ante {
     }
 
 
+    void ArgTuple::storeUnion(Compiler *c, TypedValue const& tv){
+        auto *unionTy = (AnDataType*)tv.type;
+        auto *cu = dyn_cast<Constant>(tv.val);
+        if(!cu){
+            c->errFlag = true;
+            cout << "Cannot convert non-constant union.\n";
+            throw new CompilationError("Cannot convert non-constant union.");
+        }
+
+        storeInt(c, {cu->getAggregateElement(0u), AnType::getU8()});
+    }
+
+
     void ArgTuple::storeValue(Compiler *c, TypedValue const& tv){
         switch(tv.type->typeTag){
             case TT_I8: case TT_U8: case TT_C8: case TT_Bool:
@@ -351,8 +389,14 @@ namespace ante {
                 return;
             }
             case TT_Data: storeTuple(c, tv); return;
-            case TT_Function:
             case TT_TaggedUnion:
+                //only unions with a niche layout are ever folded into a constant
+                if(getUnionLayout((AnDataType*)tv.type) != UnionLayout::Tagged){
+                    storeUnion(c, tv);
+                    return;
+                }
+                break;
+            case TT_Function:
             case TT_MetaFunction:
             case TT_FunctionList:
             case TT_Type:
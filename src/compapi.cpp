@@ -8,10 +8,12 @@ using namespace llvm;
 using namespace ante;
 using namespace ante::parser;
 
-/* Provide a callable C API from ante */
-extern "C" {
+/* The compiler API callable from ante.  These are called through the CtFunc
+ * invokers registered in init_compapi rather than by symbol name, so they
+ * use C++ linkage and may return TypedValues by value. */
+namespace ante {
 
-    TypedValue* Ante_getAST(Compiler *c){
+    TypedValue Ante_getAST(Compiler *c){
         auto *root = parser::getRootNode();
         Value *addr = c->builder.getIntN(AN_USZ_SIZE, (size_t)root);
 
@@ -19,35 +21,31 @@ extern "C" {
         auto *llvmType = c->anTypeToLlvmType(anType);
 
         Value *ptr = c->builder.CreateIntToPtr(addr, llvmType);
-        return new TypedValue(ptr, anType);
+        return TypedValue(ptr, anType);
     }
 
-    /** All api functions must return a pointer to some value,
-     * so void-returning functions return a void* nullptr by convention */
-    void* Ante_debug(Compiler *c, TypedValue &tv){
+    void Ante_debug(Compiler *c, TypedValue const& tv){
         tv.dump();
-        return nullptr;
     }
 
-    void* Ante_error(Compiler *c, TypedValue &msgTv){
+    void Ante_error(Compiler *c, TypedValue const& msgTv){
         char *msg = *(char**)ArgTuple(c, msgTv).asRawData();
         auto *curfn = c->compCtxt->callStack.back()->fdn.get();
         yy::location fakeloc = mkLoc(mkPos(0,0,0), mkPos(0,0,0));
         c->compErr(msg, curfn ? curfn->loc : fakeloc);
-        return nullptr;
     }
 
-    TypedValue* FuncDecl_getName(Compiler *c, TypedValue &fd){
+    TypedValue FuncDecl_getName(Compiler *c, TypedValue const& fd){
         FuncDecl *f = (FuncDecl*)((ConstantInt*)fd.val)->getZExtValue();
         string &n = f->getName();
 
         yy::location lloc = mkLoc(mkPos(0,0,0), mkPos(0,0,0));
         auto *strlit = new StrLitNode(lloc, n);
 
-        return new TypedValue(CompilingVisitor::compile(c, strlit));
+        return CompilingVisitor::compile(c, strlit);
     }
 
-    TypedValue* Ante_sizeof(Compiler *c, TypedValue &tv){
+    TypedValue Ante_sizeof(Compiler *c, TypedValue const& tv){
         auto size = tv.type->typeTag == TT_Type
                     ? extractTypeValue(tv)->getSizeInBits(c)
                     : tv.type->getSizeInBits(c);
@@ -58,40 +56,64 @@ extern "C" {
         }
 
         Value *sizeVal = c->builder.getIntN(AN_USZ_SIZE, size.getVal() / 8);
-        return new TypedValue(sizeVal, AnType::getUsz());
+        return TypedValue(sizeVal, AnType::getUsz());
     }
 
-    void* Ante_store(Compiler *c, TypedValue &nameTv, TypedValue &gv){
+    void Ante_store(Compiler *c, TypedValue const& nameTv, TypedValue const& gv){
         char *name = *(char**)ArgTuple(c, nameTv).asRawData();
         c->ctCtxt->ctStores[name] = gv;
-        return nullptr;
     }
 
-    TypedValue* Ante_lookup(Compiler *c, TypedValue &nameTv){
+    TypedValue Ante_lookup(Compiler *c, TypedValue const& nameTv){
         char *name = *(char**)ArgTuple(c, nameTv).asRawData();
 
         auto t = c->ctCtxt->ctStores.lookup(name);
         if(t){
-            return new TypedValue(t);
+            return t;
         }else{
             cerr << "error: ctLookup: Cannot find var '" << name << "'" << endl;
             throw new CtError();
         }
     }
 
-    void* Ante_emitIR(Compiler *c){
+    /**
+     * Returns a pointer to the process-wide global variable with the
+     * given name, creating it with the constant initial value init if it
+     * does not exist yet.  Every module sharing the same llvm::Module
+     * refers to the same variable.  It has external linkage so that the
+     * JIT shares one definition across the modules of compile-time calls.
+     */
+    TypedValue Ante_global(Compiler *c, TypedValue const& nameTv, TypedValue const& init){
+        char *name = *(char**)ArgTuple(c, nameTv).asRawData();
+
+        auto *initVal = dyn_cast<Constant>(init.val);
+        if(!initVal){
+            cerr << "error: Ante.global: initial value of '" << name << "' must be a constant" << endl;
+            throw new CtError();
+        }
+
+        auto *gv = c->module->getGlobalVariable(name, true);
+        if(!gv){
+            gv = new GlobalVariable(*c->module, initVal->getType(), false,
+                    GlobalValue::ExternalLinkage, initVal, name);
+        }else if(gv->getValueType() != initVal->getType()){
+            cerr << "error: Ante.global: '" << name << "' was already declared with a different type" << endl;
+            throw new CtError();
+        }
+        return TypedValue(gv, AnPtrType::get(init.type));
+    }
+
+    void Ante_emitIR(Compiler *c){
         if(c and c->module){
             c->module->print(llvm::errs(), nullptr);
         }else{
             cerr << "error: Ante.emitIR: null module" << endl;
         }
-        return nullptr;
     }
 
-    void* Ante_forget(Compiler *c, TypedValue &msgTv){
+    void Ante_forget(Compiler *c, TypedValue const& msgTv){
         char *msg = *(char**)ArgTuple(c, msgTv).asRawData();
-        c->mergedCompUnits->fnDecls[msg].clear();
-        return nullptr;
+        c->mergedCompUnits->getFnDecls(msg).clear();
     }
 }
 
@@ -99,61 +121,15 @@ namespace ante {
     map<string, unique_ptr<CtFunc>> compapi;
 
     void init_compapi(){
-        compapi.emplace("Ante_getAST",      new CtFunc((void*)Ante_getAST,      AnPtrType::get(AnDataType::get("Ante.Node"))));
-        compapi.emplace("Ante_debug",       new CtFunc((void*)Ante_debug,       AnType::getVoid(), {AnTypeVarType::get("'t'")}));
-        compapi.emplace("Ante_sizeof",      new CtFunc((void*)Ante_sizeof,      AnType::getU32(),  {AnTypeVarType::get("'t'")}));
-        compapi.emplace("Ante_store",       new CtFunc((void*)Ante_store,       AnType::getVoid(), {AnPtrType::get(AnType::getPrimitive(TT_C8)), AnTypeVarType::get("'t'")}));
-        compapi.emplace("Ante_lookup",      new CtFunc((void*)Ante_lookup,      AnTypeVarType::get("'t'"), {AnPtrType::get(AnType::getPrimitive(TT_C8))}));
-        compapi.emplace("Ante_error",       new CtFunc((void*)Ante_error,       AnType::getVoid(), {AnPtrType::get(AnType::getPrimitive(TT_C8))}));
-        compapi.emplace("Ante_emitIR",      new CtFunc((void*)Ante_emitIR,      AnType::getVoid()));
-        compapi.emplace("Ante_forget",      new CtFunc((void*)Ante_forget,      AnType::getVoid(), {AnPtrType::get(AnType::getPrimitive(TT_C8))}));
-        compapi.emplace("FuncDecl_getName", new CtFunc((void*)FuncDecl_getName, AnDataType::get("Str"), {AnDataType::get("Ante.FuncDecl")}));
-    }
-
-    CtFunc::CtFunc(void* f) : fn(f), params(), retty(AnType::getVoid()){}
-    CtFunc::CtFunc(void* f, AnType *retTy) : fn(f), params(), retty(retTy){}
-    CtFunc::CtFunc(void* f, AnType *retTy, vector<AnType*> p) : fn(f), params(p), retty(retTy){}
-
-    //convert void* to TypedValue*(*)(Compiler*) and call it
-    TypedValue* CtFunc::operator()(Compiler *c){
-        TypedValue* (*resfn)(Compiler*) = 0;
-        *reinterpret_cast<void**>(&resfn) = fn;
-        return resfn(c);
-    }
-
-    TypedValue* CtFunc::operator()(Compiler *c, Arg tv){
-        TypedValue* (*resfn)(Compiler*, Arg) = 0;
-        *reinterpret_cast<void**>(&resfn) = fn;
-        return resfn(c, tv);
-    }
-
-    TypedValue* CtFunc::operator()(Compiler *c, Arg tv1, Arg tv2){
-        TypedValue* (*resfn)(Compiler*, Arg, Arg) = 0;
-        *reinterpret_cast<void**>(&resfn) = fn;
-        return resfn(c, tv1, tv2);
-    }
-
-    TypedValue* CtFunc::operator()(Compiler *c, Arg tv1, Arg tv2, Arg tv3){
-        TypedValue* (*resfn)(Compiler*, Arg, Arg, Arg) = 0;
-        *reinterpret_cast<void**>(&resfn) = fn;
-        return resfn(c, tv1, tv2, tv3);
-    }
-
-    TypedValue* CtFunc::operator()(Compiler *c, Arg tv1, Arg tv2, Arg tv3, Arg tv4){
-        TypedValue* (*resfn)(Compiler*, Arg, Arg, Arg, Arg) = 0;
-        *reinterpret_cast<void**>(&resfn) = fn;
-        return resfn(c, tv1, tv2, tv3, tv4);
-    }
-
-    TypedValue* CtFunc::operator()(Compiler *c, Arg tv1, Arg tv2, Arg tv3, Arg tv4, Arg tv5){
-        TypedValue* (*resfn)(Compiler*, Arg, Arg, Arg, Arg, Arg) = 0;
-        *reinterpret_cast<void**>(&resfn) = fn;
-        return resfn(c, tv1, tv2, tv3, tv4, tv5);
-    }
-
-    TypedValue* CtFunc::operator()(Compiler *c, Arg tv1, Arg tv2, Arg tv3, Arg tv4, Arg tv5, Arg tv6){
-        TypedValue* (*resfn)(Compiler*, Arg, Arg, Arg, Arg, Arg, Arg) = 0;
-        *reinterpret_cast<void**>(&resfn) = fn;
-        return resfn(c, tv1, tv2, tv3, tv4, tv5, tv6);
+        compapi.emplace("Ante_getAST",      new CtFunc(Ante_getAST,      AnPtrType::get(AnDataType::get("Ante.Node"))));
+        compapi.emplace("Ante_debug",       new CtFunc(Ante_debug,       AnType::getVoid(), {AnTypeVarType::get("'t'")}));
+        compapi.emplace("Ante_sizeof",      new CtFunc(Ante_sizeof,      AnType::getU32(),  {AnTypeVarType::get("'t'")}));
+        compapi.emplace("Ante_store",       new CtFunc(Ante_store,       AnType::getVoid(), {AnPtrType::get(AnType::getPrimitive(TT_C8)), AnTypeVarType::get("'t'")}));
+        compapi.emplace("Ante_lookup",      new CtFunc(Ante_lookup,      AnTypeVarType::get("'t'"), {AnPtrType::get(AnType::getPrimitive(TT_C8))}));
+        compapi.emplace("Ante_global",      new CtFunc(Ante_global,      AnPtrType::get(AnTypeVarType::get("'t'")), {AnPtrType::get(AnType::getPrimitive(TT_C8)), AnTypeVarType::get("'t'")}));
+        compapi.emplace("Ante_error",       new CtFunc(Ante_error,       AnType::getVoid(), {AnPtrType::get(AnType::getPrimitive(TT_C8))}));
+        compapi.emplace("Ante_emitIR",      new CtFunc(Ante_emitIR,      AnType::getVoid()));
+        compapi.emplace("Ante_forget",      new CtFunc(Ante_forget,      AnType::getVoid(), {AnPtrType::get(AnType::getPrimitive(TT_C8))}));
+        compapi.emplace("FuncDecl_getName", new CtFunc(FuncDecl_getName, AnDataType::get("Str"), {AnDataType::get("Ante.FuncDecl")}));
     }
 }
@@ -13,7 +13,11 @@
 #include <llvm/Linker/Linker.h>
 #include <llvm/ExecutionEngine/SectionMemoryManager.h>
 #include <llvm/ExecutionEngine/GenericValue.h>
+#include <llvm/Transforms/IPO.h>
 #include <llvm/Transforms/IPO/AlwaysInliner.h>
+#include <llvm/Transforms/Instrumentation.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/CodeGen/ParallelCG.h>
 
 #include <cstdio>
 #include <cstdlib>
@@ -24,6 +28,8 @@
 #include "types.h"
 #include "repl.h"
 #include "target.h"
+#include "objectcache.h"
+#include "jit.h"
 #include "yyparser.h"
 
 using namespace std;
@@ -99,9 +105,14 @@ bool isUnsignedTypeTag(const TypeTag tt){
 
 
 void CompilingVisitor::visit(IntLitNode *n){
+    //atol would saturate unsigned literals above the maximum i64
+    uint64_t intVal = isUnsignedTypeTag(n->type)
+        ? strtoull(n->val.c_str(), nullptr, 10)
+        : atol(n->val.c_str());
+
     val = TypedValue(ConstantInt::get(*c->ctxt,
                     APInt(getBitWidthOfTypeTag(n->type),
-                    atol(n->val.c_str()), isUnsignedTypeTag(n->type))),
+                    intVal, isUnsignedTypeTag(n->type))),
             AnType::getPrimitive(n->type));
 }
 
@@ -158,22 +169,7 @@ void CompilingVisitor::visit(TypeNode *n){
         if(!unionDataTy or unionDataTy->isStub()) goto rettype;
 
         size_t tagIndex = unionDataTy->getTagVal(n->typeName);
-        Value *tag = ConstantInt::get(*c->ctxt, APInt(8, tagIndex, true));
-
-        Type *unionTy = c->anTypeToLlvmType(unionDataTy, true);
-
-        Type *curTy = tag->getType();
-
-        //allocate for the largest possible union member
-        auto *alloca = c->builder.CreateAlloca(unionTy);
-
-        //but make sure to bitcast it to the current member before storing an incorrect type
-        Value *castTo = c->builder.CreateBitCast(alloca, curTy->getPointerTo());
-        c->builder.CreateStore(tag, castTo);
-
-        //load the initial alloca, not the bitcasted one
-        Value *unionVal = c->builder.CreateLoad(alloca);
-        val = TypedValue(unionVal, unionDataTy);
+        val = createUnionValue(c, unionDataTy, tagIndex, c->getVoidLiteral(), true);
         return;
     }
 
@@ -202,37 +198,51 @@ void scanImports(Compiler *c, RootNode *r){
 }
 
 /**
- * @brief Compiles a Str literal that contains 1+ sites of string interpolation.
- * Concatenates
- *
- * @param sln The string literal to compile
- * @param pos The index of the first instance of ${ in the string
- *
- * @return The resulting concatenated Str
+ * Returns the index of the next unescaped ${ in str starting
+ * from the given index, or string::npos if there is none.
  */
-TypedValue compStrInterpolation(Compiler *c, StrLitNode *sln, int pos){
-    //get the left part of the string
-    string l = sln->val.substr(0, pos);
+size_t findInterpolation(string const& str, size_t start){
+    auto idx = str.find("${", start);
+    if(idx != string::npos and idx != 0 and str[idx-1] == '\\')
+        return string::npos;
+    return idx;
+}
 
-    //make a new sub-location for it
-    yy::location lloc = mkLoc(mkPos(sln->loc.begin.filename, sln->loc.begin.line, sln->loc.begin.column),
-		                mkPos(sln->loc.end.filename,   sln->loc.end.line,   sln->loc.begin.column + pos-1));
-    auto *ls = new StrLitNode(lloc, l);
 
+/**
+ * Returns true if values of the given type are formatted directly into
+ * an interpolated string rather than being converted to a Str first.
+ */
+bool isInterpolatedInt(AnType *t){
+    return isIntTypeTag(t->typeTag) and t->typeTag != TT_C8;
+}
 
-    auto posEnd = sln->val.find("}", pos);
-    if(posEnd == string::npos)
-        return c->compErr("Interpolated string must have a closing bracket", sln->loc);
 
-    //this is the ${...} part of the string without the ${ and }
-    string m = sln->val.substr(pos+2, posEnd - (pos+2));
+/**
+ * Returns the maximum number of characters needed to write
+ * an integer of the given type, including its sign.
+ */
+size_t maxIntStrLen(TypeTag tt){
+    bool isSigned = !isUnsignedTypeTag(tt);
+    switch(getBitWidthOfTypeTag(tt)){
+        case 8:  return 3 + isSigned;
+        case 16: return 5 + isSigned;
+        case 32: return 10 + isSigned;
+        default: return 20;
+    }
+}
 
-    string r = sln->val.substr(posEnd+1);
-    yy::location rloc = mkLoc(mkPos(sln->loc.begin.filename, sln->loc.begin.line, sln->loc.begin.column + posEnd + 1),
-							  mkPos(sln->loc.end.filename,   sln->loc.end.line,   sln->loc.end.column));
-    auto *rs = new StrLitNode(rloc, r);
 
-    //now that the string is separated, begin interpolation preparation
+/**
+ * @brief Parses and compiles the expression within a single ${...}
+ * of an interpolated string, converting it to a Str if needed.
+ *
+ * @param pos The index of the ${ in the string
+ * @param end The index of the closing }
+ */
+TypedValue compInterpolatedExpr(Compiler *c, StrLitNode *sln, size_t pos, size_t end){
+    //this is the ${...} part of the string without the ${ and }
+    string m = sln->val.substr(pos+2, end - (pos+2));
 
     //lex and parse
     auto *lex = new Lexer(sln->loc.begin.filename, m,
@@ -264,6 +274,10 @@ TypedValue compStrInterpolation(Compiler *c, StrLitNode *sln, int pos){
 
     if(!val) return val;
 
+    //integers are written directly into the resulting string
+    if(!c->isJIT and isInterpolatedInt(val.type))
+        return val;
+
     //if the expr is not already a string type, cast it to one
     auto *strty = dyn_cast<AnDataType>(val.type);
     if(!strty or strty->name != "Str"){
@@ -272,8 +286,6 @@ TypedValue compStrInterpolation(Compiler *c, StrLitNode *sln, int pos){
         auto fnty = AnFunctionType::get(c, AnType::getVoid(), fd->fdn->params.get());
 
         if(!fd or !c->typeEq(fnty->extTys, {val.type})){
-            delete ls;
-            delete rs;
             return c->compErr("Cannot cast " + anTypeToColoredStr(val.type)
                 + " to Str for string interpolation.", valNode->loc);
         }
@@ -285,36 +297,131 @@ TypedValue compStrInterpolation(Compiler *c, StrLitNode *sln, int pos){
             val = TypedValue(c->builder.CreateCall(fn.val, val.val), strty);
         }
     }
+    return val;
+}
 
-    //Finally, the interpolation is done.  Now just combine the three strings
-    //get the ++_Str_Str function
-    string appendFn = "++";
-    string mangledAppendFn = "++_Str_Str";
-    auto lstr = CompilingVisitor::compile(c, ls);
-    auto rstr = CompilingVisitor::compile(c, rs);
 
+/**
+ * @brief Compiles a Str literal that contains 1+ sites of string interpolation.
+ *
+ * Each part is appended to a StrBuilder whose capacity is computed up front
+ * from the length of each literal part, each interpolated Str, and the
+ * maximum length of each interpolated integer so that the whole string is
+ * written into a single allocation.
+ *
+ * @param sln The string literal to compile
+ * @param pos The index of the first instance of ${ in the string
+ *
+ * @return The resulting concatenated Str
+ */
+TypedValue compStrInterpolation(Compiler *c, StrLitNode *sln, int pos){
+    AnType *strty = AnDataType::get("Str");
+
+    //split the string into its literal parts and the values between them,
+    //lits[i] always precedes vals[i]
+    vector<string> lits;
+    vector<TypedValue> vals;
+
+    size_t start = 0;
+    size_t idx = pos;
+    while(idx != string::npos){
+        lits.push_back(sln->val.substr(start, idx - start));
+
+        auto end = sln->val.find("}", idx);
+        if(end == string::npos)
+            return c->compErr("Interpolated string must have a closing bracket", sln->loc);
+
+        auto val = compInterpolatedExpr(c, sln, idx, end);
+        if(!val) return val;
+        vals.push_back(val);
+
+        start = end + 1;
+        idx = findInterpolation(sln->val, start);
+    }
+    lits.push_back(sln->val.substr(start));
+
+    //Ante functions cannot be called from within the JIT without
+    //compiling them first so just combine each part with ++
     if(c->isJIT){
-        auto appendL = compileAndCallAnteFunction(c, appendFn, mangledAppendFn, {lstr, val});
-        return compileAndCallAnteFunction(c, appendFn, mangledAppendFn, {appendL, rstr});
+        StrLitNode first{sln->loc, lits[0]};
+        auto str = CompilingVisitor::compile(c, &first);
+
+        for(size_t i = 0; i < vals.size(); i++){
+            StrLitNode lit{sln->loc, lits[i+1]};
+            auto rstr = CompilingVisitor::compile(c, &lit);
+
+            str = compileAndCallAnteFunction(c, "++", "++_Str_Str", {str, vals[i]});
+            str = compileAndCallAnteFunction(c, "++", "++_Str_Str", {str, rstr});
+        }
+        return str;
     }
 
-    auto fn = c->getFunction(appendFn, mangledAppendFn);
-    if(!fn) return c->compErr("++ overload for Str and Str not found while performing Str interpolation."
+    auto *builderTy = AnDataType::get("StrBuilder");
+    auto initFn = c->getFunction("StrBuilder_init", mangle("StrBuilder_init", {AnType::getUsz()}));
+    auto appendStr = c->getFunction("StrBuilder_append", mangle("StrBuilder_append", {builderTy, strty}));
+    auto appendI64 = c->getFunction("StrBuilder_append", mangle("StrBuilder_append", {builderTy, AnType::getI64()}));
+    auto appendU64 = c->getFunction("StrBuilder_append", mangle("StrBuilder_append", {builderTy, AnType::getU64()}));
+    auto toStr = c->getFunction("StrBuilder_to_str", mangle("StrBuilder_to_str", {builderTy}));
+
+    if(!initFn or !appendStr or !appendI64 or !appendU64 or !toStr)
+        return c->compErr("StrBuilder not found while performing Str interpolation."
             "  The prelude may not be imported correctly.", sln->loc);
 
-    //call the ++ function to combine the three strings
-    auto *appendL = c->builder.CreateCall(fn.val, vector<Value*>{lstr.val, val.val});
-    auto *appendR = c->builder.CreateCall(fn.val, vector<Value*>{appendL, rstr.val});
+    //sum the length of each part, or the most an integer part can need, so the
+    //StrBuilder never needs to grow.  Its integer appends reserve only the
+    //characters actually written, which never exceeds maxIntStrLen.
+    Type *uszTy = c->builder.getIntNTy(AN_USZ_SIZE);
+    size_t constLen = 0;
+    for(auto &lit : lits)
+        constLen += lit.size();
+
+    Value *len = nullptr;
+    for(auto &val : vals){
+        if(isInterpolatedInt(val.type)){
+            constLen += maxIntStrLen(val.type->typeTag);
+        }else{
+            Value *strLen = c->builder.CreateExtractValue(val.val, 1);
+            len = len ? c->builder.CreateAdd(len, strLen) : strLen;
+        }
+    }
+
+    Value *cap = ConstantInt::get(uszTy, constLen);
+    if(len) cap = c->builder.CreateAdd(len, cap);
 
-    //create the returning typenode
-    return TypedValue(appendR, strty);
+    //StrBuilder's append functions take it as a mut parameter, so it needs an address
+    Value *sb = c->builder.CreateAlloca(c->anTypeToLlvmType(builderTy));
+    c->builder.CreateStore(c->builder.CreateCall(initFn.val, cap), sb);
+
+    for(size_t i = 0; i <= vals.size(); i++){
+        if(!lits[i].empty()){
+            StrLitNode lit{sln->loc, lits[i]};
+            auto litStr = CompilingVisitor::compile(c, &lit);
+            c->builder.CreateCall(appendStr.val, vector<Value*>{sb, litStr.val});
+        }
+
+        if(i == vals.size())
+            break;
+
+        auto &val = vals[i];
+        if(isInterpolatedInt(val.type)){
+            bool isSigned = !isUnsignedTypeTag(val.type->typeTag);
+            auto &appendFn = isSigned ? appendI64 : appendU64;
+            Value *x = c->builder.CreateIntCast(val.val, c->builder.getInt64Ty(), isSigned);
+            c->builder.CreateCall(appendFn.val, vector<Value*>{sb, x});
+        }else{
+            c->builder.CreateCall(appendStr.val, vector<Value*>{sb, val.val});
+        }
+    }
+
+    auto *str = c->builder.CreateCall(toStr.val, c->builder.CreateLoad(sb));
+    return TypedValue(str, strty);
 }
 
 
 void CompilingVisitor::visit(StrLitNode *n){
-    auto idx = n->val.find("${");
+    auto idx = findInterpolation(n->val, 0);
 
-    if(idx != string::npos and (idx == 0 or n->val.find("\\${") != idx - 1)){
+    if(idx != string::npos){
         this->val = compStrInterpolation(c, n, idx);
         return;
     }
@@ -1219,8 +1326,8 @@ void CompilingVisitor::visit(ExtNode *n){
                 shared_ptr<FuncDecl> fd{new FuncDecl(spfdn, mangledName, c->scope, c->mergedCompUnits)};
                 traitImpl->funcs.emplace_back(fd);
 
-                c->compUnit->fnDecls[fdn->name].emplace_back(fd);
-                c->mergedCompUnits->fnDecls[fdn->name].emplace_back(fd);
+                c->compUnit->getFnDecls(fdn->name).emplace_back(fd);
+                c->mergedCompUnits->getFnDecls(fdn->name).emplace_back(fd);
             }
 
             //trait is fully implemented, add it to the DataType
@@ -1289,6 +1396,13 @@ TypedValue compTaggedUnion(Compiler *c, DataDeclNode *n){
     vector<AnType*> unionTypes;
     AnDataType *data = AnDataType::create(union_name, {}, true, toVec(c, n->generics));
 
+    //the tag is the smallest integer that can hold each variant's index
+    size_t numVariants = 0;
+    for(auto *v = nvn; v; v = (NamedValNode*)v->next.get())
+        numVariants++;
+
+    AnType *tagIntTy = numVariants <= 256 ? AnType::getU8() : AnType::getU16();
+
     while(nvn){
         TypeNode *tyn = (TypeNode*)nvn->typeExpr.get();
         AnType *tagTy = tyn->extTy ? toAnType(c, tyn->extTy.get()) : AnType::getVoid();
@@ -1300,8 +1414,8 @@ TypedValue compTaggedUnion(Compiler *c, DataDeclNode *n){
             exts.push_back(tagTy);
         }
 
-        //Each union member's type is a tuple of the tag (a u8 value), and the user-defined value
-        auto *tup = AnAggregateType::get(TT_Tuple, {AnType::getU8(), tagTy});
+        //Each union member's type is a tuple of the tag, and the user-defined value
+        auto *tup = AnAggregateType::get(TT_Tuple, {tagIntTy, tagTy});
 
         //Store the tag as a UnionTag and a AnDataType
         AnDataType *tagdt = AnDataType::create(nvn->name, exts, false, toVec(c, n->generics));
@@ -1492,7 +1606,7 @@ void CompilingVisitor::visit(MatchBranchNode *n){
 void ante::Module::import(ante::Module *mod){
     for(auto& pair : mod->fnDecls)
         for(auto& fd : pair.second)
-            fnDecls[pair.first()].push_back(fd);
+            getFnDecls(pair.first()).push_back(fd);
 
     for(auto& pair : mod->userTypes)
         userTypes[pair.first()] = pair.second;
@@ -1501,6 +1615,48 @@ void ante::Module::import(ante::Module *mod){
         traits[pair.first()] = pair.second;
 }
 
+vector<shared_ptr<FuncDecl>>& ante::Module::getFnDecls(StringRef name){
+    auto it = fnDecls.find(name);
+    if(it != fnDecls.end() or !parent)
+        return fnDecls[name];
+
+    auto &list = fnDecls[name];
+    if(auto *parentList = parent->findFnDecls(name)){
+        for(auto &fd : *parentList){
+            auto fd_cpy = make_shared<FuncDecl>(fd->fdn, fd->mangledName, fd->scope, this);
+            fd_cpy->obj = fd->obj;
+            fd_cpy->obj_bindings = fd->obj_bindings;
+            list.push_back(fd_cpy);
+        }
+    }
+    return list;
+}
+
+
+const vector<shared_ptr<FuncDecl>>* ante::Module::findFnDecls(StringRef name) const{
+    auto it = fnDecls.find(name);
+    if(it != fnDecls.end())
+        return &it->getValue();
+    return parent ? parent->findFnDecls(name) : nullptr;
+}
+
+
+AnDataType* ante::Module::lookupType(StringRef name) const{
+    auto it = userTypes.find(name);
+    if(it != userTypes.end())
+        return it->getValue();
+    return parent ? parent->lookupType(name) : nullptr;
+}
+
+
+Trait* ante::Module::lookupTrait(StringRef name) const{
+    auto it = traits.find(name);
+    if(it != traits.end())
+        return it->getValue().get();
+    return parent ? parent->lookupTrait(name) : nullptr;
+}
+
+
 inline bool fileExists(const string &fName){
     if(FILE *f = fopen(fName.c_str(), "r")){
         fclose(f);
@@ -1721,8 +1877,8 @@ Function* Compiler::createMainFn(){
 
     //TODO: merge this code with Compiler::registerFunction
     shared_ptr<FuncDecl> fd{main_var};
-    compUnit->fnDecls[fnName].push_back(fd);
-    mergedCompUnits->fnDecls[fnName].push_back(fd);
+    compUnit->getFnDecls(fnName).push_back(fd);
+    mergedCompUnits->getFnDecls(fnName).push_back(fd);
 
     compCtxt->callStack.push_back(main_var);
     return main;
@@ -1802,6 +1958,22 @@ void Compiler::compile(){
 
     if(!errFlag and !isLib){
         legacy::PassManager pm;
+
+        //Profile instrumentation must be added at the same point in the pipeline
+        //in both the generating and using compiles so their CFGs match.
+        if(profileGenerate){
+            pm.add(createPGOInstrumentationGenLegacyPass());
+            pm.add(createInstrProfilingLegacyPass());
+        }else if(!profileUseFile.empty()){
+            pm.add(createPGOInstrumentationUseLegacyPass(profileUseFile));
+
+            //addPasses has no inliner of its own, add one that reads the
+            //profile's entry counts so that hot call sites are inlined
+            //with a higher threshold and cold ones are left alone.
+            if(optLvl > 0)
+                pm.add(createFunctionInliningPass(optLvl, 0, false));
+        }
+
         addPasses(pm, optLvl);
         pm.run(*module);
     }
@@ -1821,11 +1993,35 @@ void Compiler::compileNative(){
 
     //this file will become the obj file before linking
     string objFile = outFile + ".o";
+    vector<string> objFiles;
+
+    int res;
+    if(useThinLTO)
+        res = compileWithThinLTO(module.get(), bitcodeFiles, outFile, objFiles);
+    else if(isIncremental)
+        res = compileModulesToObjs(module.get(), objFiles);
+    else
+        res = compileIRtoObjs(module.get(), objFile, objFiles);
+
+    if(!res){
+        string inFiles = "";
+        for(auto &f : objFiles)
+            inFiles += f + " ";
+
+        if(profileGenerate)
+            inFiles += AN_PROFILE_RT;
 
-    if(!compileIRtoObj(module.get(), objFile)){
-        linkObj(objFile, outFile);
-        remove(objFile.c_str());
+        linkObj(inFiles, outFile);
     }
+
+    //prune only once linking is done so that none of this build's objects are evicted first
+    if(isIncremental and !useThinLTO)
+        pruneCacheDir(AN_CACHE_DIR, AN_CACHE_MAX_SIZE);
+
+    //cached objects are kept for the next build
+    if(useThinLTO or !isIncremental)
+        for(auto &f : objFiles)
+            remove(f.c_str());
 }
 
 int Compiler::compileObj(string &outName){
@@ -1888,24 +2084,22 @@ TargetMachine* getTargetMachine(){
 
 
 void Compiler::jitFunction(Function *f){
-    if(!jit.get()){
-        auto* eBuilder = new EngineBuilder(unique_ptr<llvm::Module>(module.get()));
-
-        string err;
-
-        jit.reset(eBuilder->setErrorStr(&err).setEngineKind(EngineKind::JIT).create());
-        if(err.length() > 0) cerr << err << endl;
-    }
-
-    compileIRtoObj(module.get(), (".tmp_" + f->getName()).str());
-    jit->addModule(move(module));
-    jit->finalizeObject();
-    remove((".tmp_" + f->getName()).str().c_str());
-
-    auto* fn = jit->getPointerToFunction(f);
-
+    //!run functions share the tiered JIT of compile-time calls so that
+    //anything hot they call is optimized and can be reused by later calls
+    auto &jit = ctCtxt->jit;
+    if(!jit)
+        jit.reset(new JIT(ctCtxt->jitCacheDir));
+
+    //the function is only ever run once so its module is removed afterward
+    jit->prepareModule(*module, {f}, true);
+    string fnName = f->getName();
+    jit->addTemporaryModule(move(module));
+
+    auto fn = (void(*)())jit->getSymbolAddress(fnName);
     if(fn)
-        reinterpret_cast<void(*)()>(fn)();
+        fn();
+
+    jit->removeTemporaryModules();
 }
 
 
@@ -1931,6 +2125,56 @@ int Compiler::compileIRtoObj(llvm::Module *mod, string outFile){
 }
 
 
+int Compiler::compileIRtoObjs(llvm::Module *mod, string outFile, vector<string> &objFiles){
+    if(codegenThreads <= 1){
+        objFiles.push_back(outFile);
+        return compileIRtoObj(mod, outFile);
+    }
+
+    vector<unique_ptr<raw_fd_ostream>> outs;
+    vector<raw_pwrite_stream*> outPtrs;
+
+    for(unsigned int i = 0; i < codegenThreads; i++){
+        string partFile = outFile + "." + to_string(i);
+        objFiles.push_back(partFile);
+
+        std::error_code errCode;
+        outs.emplace_back(new raw_fd_ostream(partFile, errCode, sys::fs::OpenFlags::F_None));
+
+        if(errCode){
+            cerr << "Error when opening " << partFile << ": " << errCode.message() << endl;
+            return 1;
+        }
+        outPtrs.push_back(outs.back().get());
+    }
+
+    //splitCodeGen consumes the module it is given and the module is still
+    //needed afterward (eg. by the JIT) so hand it a copy instead.  Each partition
+    //is moved into its own LLVMContext and given its own TargetMachine so
+    //that they can be safely compiled on separate threads.
+#if LLVM_VERSION_MAJOR >= 7
+    auto copy = CloneModule(*mod);
+#else
+    auto copy = CloneModule(mod);
+#endif
+
+    splitCodeGen(move(copy), outPtrs, {}, [](){
+        return unique_ptr<TargetMachine>(getTargetMachine());
+    });
+
+    int res = 0;
+    for(auto &out : outs){
+        out->close();
+        if(out->has_error()){
+            cerr << "Error when writing object file " << objFiles[&out - &outs[0]] << endl;
+            out->clear_error();
+            res = 1;
+        }
+    }
+    return res;
+}
+
+
 int Compiler::linkObj(string inFiles, string outFile){
     string cmd = AN_LINKER " " + inFiles + " -static -o " + outFile;
     return system(cmd.c_str());
@@ -2078,19 +2322,11 @@ AnType* Compiler::lookupTypeVar(string const& name) const{
 
 
 AnDataType* Compiler::lookupType(string const& tyname) const{
-    auto& ut = mergedCompUnits->userTypes;
-    auto it = ut.find(tyname);
-    if(it != ut.end())
-        return it->getValue();
-    return nullptr;
+    return mergedCompUnits->lookupType(tyname);
 }
 
 Trait* Compiler::lookupTrait(string const& tyname) const{
-    auto& ts = mergedCompUnits->traits;
-    auto it = ts.find(tyname);
-    if(it != ts.end())
-        return it->getValue().get();
-    return nullptr;
+    return mergedCompUnits->lookupTrait(tyname);
 }
 
 
@@ -2174,9 +2410,12 @@ Compiler::Compiler(const char *_fileName, bool lib, shared_ptr<LLVMContext> llvm
         compiled(false),
         isLib(lib),
         isJIT(false),
+        isIncremental(false),
+        useThinLTO(false),
+        profileGenerate(false),
         fileName(_fileName? _fileName : "(stdin)"),
         funcPrefix(""),
-        scope(0), optLvl(2), fnScope(1){
+        scope(0), optLvl(2), fnScope(1), codegenThreads(1){
 
     //The lexer stores the fileName in the loc field of all Nodes. The fileName is copied
     //to let Node's outlive the Compiler they were made in, ensuring they work with imports.
@@ -2241,10 +2480,13 @@ Compiler::Compiler(Compiler *c, Node *root, string modName, bool lib) :
         compiled(false),
         isLib(lib),
         isJIT(false),
+        isIncremental(false),
+        useThinLTO(false),
+        profileGenerate(false),
         fileName(c->fileName),
         outFile(modName),
         funcPrefix(""),
-        scope(0), optLvl(2), fnScope(1){
+        scope(0), optLvl(2), fnScope(1), codegenThreads(1){
 
     allMergedCompUnits.emplace_back(mergedCompUnits);
     allCompiledModules.try_emplace(fileName, compUnit);
@@ -2279,6 +2521,29 @@ void Compiler::processArgs(CompilerArgs *args){
         else{ cerr << "Unrecognized OptLvl " << arg->arg << endl; return; }
     }
 
+    if(auto *arg = args->getArg(Args::CodegenThreads)){
+        int threads = atoi(arg->arg.c_str());
+        if(threads <= 0){ cerr << "Invalid number of codegen threads " << arg->arg << endl; return; }
+        codegenThreads = threads;
+    }
+
+    if(args->hasArg(Args::Incremental))
+        isIncremental = true;
+
+    if(args->hasArg(Args::ProfileGenerate))
+        profileGenerate = true;
+
+    if(auto *arg = args->getArg(Args::ProfileUse))
+        profileUseFile = arg->arg;
+
+    if(auto *arg = args->getArg(Args::JITCache))
+        ctCtxt->jitCacheDir = arg->arg;
+
+    if(args->hasArg(Args::ThinLTO)){
+        useThinLTO = true;
+        bitcodeFiles = args->bitcodeFiles;
+    }
+
 
     //make sure even non-called functions are included in the binary
     //if the -lib flag is set
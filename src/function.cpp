@@ -156,8 +156,7 @@ AnType* validateReturns(Compiler *c, FuncDecl *fd, TypeNode *retTy = 0){
                 auto *ins = ri ? ri->getParent() : c->builder.GetInsertBlock();
                 c->builder.SetInsertPoint(ins);
 
-                auto *cast = c->builder.CreateBitCast(alloca, c->anTypeToLlvmType(matchTy)->getPointerTo());
-                auto *fixed_ret = c->builder.CreateLoad(cast);
+                auto *fixed_ret = loadAsType(c, alloca, matchTy);
                 c->builder.CreateRet(fixed_ret);
                 if(ri) ri->eraseFromParent();
             }
@@ -341,6 +340,9 @@ TypedValue compFnWithModifiers(Compiler *c, FuncDecl *fd, ModNode *ppn){
 
                 c->jitFunction((Function*)recomp.val);
                 c->module.reset(mod);
+            }else if(vn->name == "pure"){
+                //Calls to pure compile-time functions are memoized by compMetaFunctionResult
+                fn = c->compFn(fd);
             }else if(vn->name == "on_fn_decl"){
                 auto *rettn = (TypeNode*)fdn->type.get();
                 auto *fnty = AnFunctionType::get(c, toAnType(c, rettn), fdn->params.get(), true);
@@ -658,7 +660,7 @@ FuncDecl* Compiler::getCurrentFunction() const{
 
 
 void Compiler::updateFn(TypedValue &f, FuncDecl *fd, string &name, string &mangledName){
-    auto &list = mergedCompUnits->fnDecls[name];
+    auto &list = mergedCompUnits->getFnDecls(name);
     auto *vec_fd = getFuncDeclFromVec(list, mangledName);
     if(vec_fd){
         vec_fd->tv = f;
@@ -818,7 +820,7 @@ TypedValue Compiler::getMangledFn(string name, vector<AnType*> &args){
 
 
 vector<shared_ptr<FuncDecl>>& Compiler::getFunctionList(string const& name) const{
-    return mergedCompUnits->fnDecls[name];
+    return mergedCompUnits->getFnDecls(name);
 }
 
 
@@ -922,8 +924,8 @@ void Compiler::registerFunction(FuncDeclNode *fn, string &mangledName){
         }
     }
 
-    compUnit->fnDecls[fn->name].push_back(fd);
-    mergedCompUnits->fnDecls[fn->name].push_back(fd);
+    compUnit->getFnDecls(fn->name).push_back(fd);
+    mergedCompUnits->getFnDecls(fn->name).push_back(fd);
 }
 
 } //end of namespace ante
@@ -0,0 +1,321 @@
+/*
+ *      incremental.cpp
+ * Splits a compiled llvm::Module into one object file per
+ * ante::Module and caches each object by the hash of its IR so
+ * that rebuilds skip code generation for modules whose IR did not
+ * change.  Every module is still parsed and lowered to IR.
+ * The JIT's objects are cached the same way.
+ */
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include "compiler.h"
+#include "objectcache.h"
+#include "target.h"
+
+using namespace std;
+using namespace llvm;
+
+namespace ante {
+
+/**
+ * Maps the name of each function defined within an imported ante::Module
+ * to the name of the file it was declared in.  Anything not in this map,
+ * eg. main, lambdas, and generic instantiations, belongs to the root module.
+ */
+StringMap<string> getFunctionOwners(Compiler *c){
+    StringMap<string> owners;
+
+    for(auto &pair : allCompiledModules){
+        auto *mod = pair.second.get();
+        if(mod == c->compUnit)
+            continue;
+
+        for(auto &fdList : mod->fnDecls){
+            for(auto &fd : fdList.second){
+                if(fd->module != mod or !fd->tv)
+                    continue;
+
+                if(auto *f = dyn_cast<Function>(fd->tv.val))
+                    owners[f->getName()] = pair.first();
+            }
+        }
+    }
+    return owners;
+}
+
+
+/**
+ * Clones the parts of mod belonging to the given owner.
+ *
+ * Definitions belonging to other owners are only declared, and any
+ * declarations or private constants left unused are removed so that
+ * the resulting module (and thus its hash) does not change when
+ * unrelated modules do.
+ */
+unique_ptr<llvm::Module> extractPartition(llvm::Module *mod, StringMap<string> &owners, StringRef owner){
+    ValueToValueMapTy vmap;
+
+    auto shouldClone = [&](const GlobalValue *gv){
+        if(auto *gvar = dyn_cast<GlobalVariable>(gv)){
+            //constants are duplicated in every partition that uses them
+            if(gvar->isConstant() and gvar->hasLocalLinkage())
+                return true;
+            return owner.empty();
+        }
+
+        auto it = owners.find(gv->getName());
+        return it == owners.end() ? owner.empty() : it->second == owner;
+    };
+
+#if LLVM_VERSION_MAJOR >= 7
+    auto part = CloneModule(*mod, vmap, shouldClone);
+#else
+    auto part = CloneModule(mod, vmap, shouldClone);
+#endif
+
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(auto it = part->global_begin(); it != part->global_end();){
+            GlobalVariable &gv = *it++;
+            if(gv.use_empty() and (gv.isDeclaration() or gv.hasLocalLinkage())){
+                gv.eraseFromParent();
+                changed = true;
+            }
+        }
+        for(auto it = part->begin(); it != part->end();){
+            Function &f = *it++;
+            if(f.use_empty() and f.isDeclaration()){
+                f.eraseFromParent();
+                changed = true;
+            }
+        }
+    }
+
+    //The names of private values depend on the order they were created in the
+    //whole program, strip them so they do not affect the partition's hash.
+    for(auto &gv : part->globals())
+        if(gv.hasLocalLinkage())
+            gv.setName("");
+
+    return part;
+}
+
+
+string hashPartition(const llvm::Module *mod, unsigned int optLvl, StringRef triple){
+    SmallVector<char, 0> buf;
+    raw_svector_ostream os{buf};
+
+#if LLVM_VERSION_MAJOR >= 7
+    WriteBitcodeToFile(*mod, os);
+#else
+    WriteBitcodeToFile(mod, os);
+#endif
+
+    MD5 hash;
+    hash.update(StringRef(buf.data(), buf.size()));
+    hash.update(triple);
+    hash.update(to_string(optLvl));
+
+    MD5::MD5Result res;
+    hash.final(res);
+
+    SmallString<32> str;
+    MD5::stringifyResult(res, str);
+    return str.str();
+}
+
+
+void touchCachedObject(StringRef file){
+    int fd;
+    if(sys::fs::openFileForWrite(file, fd, sys::fs::F_Append))
+        return;
+
+#if LLVM_VERSION_MAJOR >= 8
+    sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+#else
+    sys::fs::setLastModificationAndAccessTime(fd, std::chrono::system_clock::now());
+#endif
+    sys::Process::SafelyCloseFileDescriptor(fd);
+}
+
+
+void pruneCacheDir(StringRef dir, uint64_t maxBytes){
+    struct CachedObject {
+        string path;
+        sys::TimePoint<> lastUsed;
+        uint64_t size;
+    };
+
+    vector<CachedObject> objs;
+    uint64_t total = 0;
+
+    std::error_code errCode;
+    for(sys::fs::directory_iterator it{dir, errCode}, end; it != end and !errCode; it.increment(errCode)){
+        string path = it->path();
+        if(sys::path::extension(path) != ".o")
+            continue;
+
+        sys::fs::file_status status;
+        if(sys::fs::status(path, status))
+            continue;
+
+        objs.push_back({path, status.getLastModificationTime(), status.getSize()});
+        total += status.getSize();
+    }
+
+    if(total <= maxBytes)
+        return;
+
+    std::sort(objs.begin(), objs.end(), [](CachedObject const& l, CachedObject const& r){
+        return l.lastUsed < r.lastUsed;
+    });
+
+    for(auto &obj : objs){
+        if(total <= maxBytes)
+            break;
+
+        if(!sys::fs::remove(obj.path))
+            total -= obj.size;
+    }
+}
+
+
+vector<unique_ptr<llvm::Module>> splitByAnteModule(Compiler *c, llvm::Module *mod){
+    //Functions referenced across partitions cannot be private to any one of them
+#if LLVM_VERSION_MAJOR >= 7
+    auto copy = CloneModule(*mod);
+#else
+    auto copy = CloneModule(mod);
+#endif
+    for(auto &f : *copy){
+        if(f.hasLocalLinkage() and !f.isDeclaration()){
+            f.setLinkage(GlobalValue::ExternalLinkage);
+            f.setVisibility(GlobalValue::HiddenVisibility);
+        }
+    }
+    for(auto &gv : copy->globals()){
+        if(gv.hasLocalLinkage() and !gv.isConstant()){
+            gv.setLinkage(GlobalValue::ExternalLinkage);
+            gv.setVisibility(GlobalValue::HiddenVisibility);
+        }
+    }
+
+    auto owners = getFunctionOwners(c);
+
+    StringMap<bool> partitionNames;
+    for(auto &pair : owners)
+        partitionNames[pair.second] = true;
+
+    //the root module, with an empty owner name, is always emitted first
+    vector<unique_ptr<llvm::Module>> partitions;
+    partitions.push_back(extractPartition(copy.get(), owners, ""));
+
+    for(auto &pair : partitionNames)
+        partitions.push_back(extractPartition(copy.get(), owners, pair.first()));
+
+    return partitions;
+}
+
+
+int Compiler::compileModulesToObjs(llvm::Module *mod, vector<string> &objFiles){
+    if(auto err = sys::fs::create_directories(AN_CACHE_DIR)){
+        cerr << "Error when creating cache directory " AN_CACHE_DIR ": " << err.message() << endl;
+        return 1;
+    }
+
+    for(auto &part : splitByAnteModule(this, mod)){
+        string objFile = AN_CACHE_DIR "/" + hashPartition(part.get(), optLvl, AN_TARGET_TRIPLE) + ".o";
+        objFiles.push_back(objFile);
+
+        if(sys::fs::exists(objFile)){
+            touchCachedObject(objFile);
+            continue;
+        }
+
+        //compile to a uniquely-named temporary file first so that neither an
+        //interrupted build nor a concurrent one can leave a partially-written
+        //object in the cache
+        SmallString<128> tmpFile;
+        if(auto err = sys::fs::createUniqueFile(objFile + ".%%%%%%.tmp", tmpFile)){
+            cerr << "Error when creating temporary file for " << objFile << ": " << err.message() << endl;
+            return 1;
+        }
+
+        if(compileIRtoObj(part.get(), tmpFile.str().str())){
+            sys::fs::remove(tmpFile);
+            return 1;
+        }
+
+        if(auto err = sys::fs::rename(tmpFile, objFile)){
+            cerr << "Error when moving " << tmpFile.str().str() << " to " << objFile << ": " << err.message() << endl;
+            sys::fs::remove(tmpFile);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+string JITObjectCache::getCacheFile(const llvm::Module *m) const{
+    //The JIT always targets the host rather than AN_TARGET_TRIPLE
+    return dir + "/" + hashPartition(m, optLvl, sys::getProcessTriple()) + ".o";
+}
+
+
+JITObjectCache::~JITObjectCache(){
+    if(objectsAdded)
+        pruneCacheDir(dir, AN_CACHE_MAX_SIZE);
+}
+
+
+void JITObjectCache::notifyObjectCompiled(const llvm::Module *m, MemoryBufferRef obj){
+    if(sys::fs::create_directories(dir))
+        return;
+
+    //A failure to cache an object is not an error, it will just be compiled again
+    string objFile = getCacheFile(m);
+
+    int fd;
+    SmallString<128> tmpFile;
+    if(sys::fs::createUniqueFile(objFile + ".%%%%%%.tmp", fd, tmpFile))
+        return;
+
+    raw_fd_ostream out{fd, /*shouldClose*/ true};
+    out << obj.getBuffer();
+    out.close();
+
+    if(out.has_error()){
+        out.clear_error();
+        sys::fs::remove(tmpFile);
+    }else if(sys::fs::rename(tmpFile, objFile)){
+        sys::fs::remove(tmpFile);
+    }else{
+        objectsAdded = true;
+    }
+}
+
+
+unique_ptr<MemoryBuffer> JITObjectCache::getObject(const llvm::Module *m){
+    string objFile = getCacheFile(m);
+    auto buf = MemoryBuffer::getFile(objFile);
+    if(!buf)
+        return nullptr;
+
+    touchCachedObject(objFile);
+
+    return move(*buf);
+}
+
+} //end of namespace ante
@@ -1,4 +1,9 @@
 #include "jit.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include <iostream>
 
 using namespace std;
@@ -7,12 +12,30 @@ using namespace llvm::orc;
 
 namespace ante {
 
-    JIT::ModuleHandle JIT::addModule(std::unique_ptr<Module> m){
-        auto symResolver = createLambdaResolver(
+    JIT::~JIT(){
+        if(optimizer.joinable()){
+            {
+                lock_guard<mutex> lock{tierMutex};
+                stopping = true;
+            }
+            tierCv.notify_one();
+            optimizer.join();
+        }
+    }
+
+    shared_ptr<JITSymbolResolver> JIT::createResolver(){
+        return createLambdaResolver(
             //Look back into the JIT itself to find symbols part of the same dylib
             [&](const string &name){
                 if(auto sym = codLayer.findSymbol(name, false))
                     return sym;
+
+                //Referenced by name rather than address by instrumented
+                //functions so that their objects can be cached
+                if(name == mangle("AnteJIT_instance"))
+                    return JITSymbol((JITTargetAddress)this, JITSymbolFlags::Exported);
+                if(name == mangle("AnteJIT_onHotFunction"))
+                    return JITSymbol((JITTargetAddress)&JIT::onHotFunction, JITSymbolFlags::Exported);
                 return JITSymbol(nullptr);
             },
             //search for external symbols in the host process
@@ -22,33 +45,191 @@ namespace ante {
                 return JITSymbol(nullptr);
             }
         );
+    }
 
-        return cantFail(codLayer.addModule(move(m), move(symResolver)));
+    JIT::ModuleHandle JIT::addModule(std::unique_ptr<Module> m){
+        linkOptimizedFunctions();
+        return cantFail(codLayer.addModule(move(m), createResolver()));
     }
 
+    /*
+     * Each module given to this layer is a partition of a single function
+     * created by the CompileOnDemandLayer just before the function is first
+     * called.  It is compiled as-is at -O0 but instrumented to count its calls
+     * so that it can be recompiled at -O2 once it becomes hot.
+     */
     std::shared_ptr<Module> JIT::optimizeModule(std::shared_ptr<Module> m){
-        auto fpm = llvm::make_unique<legacy::FunctionPassManager>(m.get());
+        for(auto &f : *m){
+            if(f.isDeclaration())
+                continue;
 
-        fpm->add(createInstructionCombiningPass());
-        fpm->add(createReassociatePass());
-        fpm->add(createGVNPass());
-        fpm->add(createCFGSimplificationPass());
-        fpm->doInitialization();
+            string bitcode;
+            raw_string_ostream os{bitcode};
+#if LLVM_VERSION_MAJOR >= 7
+            WriteBitcodeToFile(*m, os);
+#else
+            WriteBitcodeToFile(m.get(), os);
+#endif
+            os.flush();
 
-        for(auto &f : *m){
-            fpm->run(f);
+            {
+                lock_guard<mutex> lock{tierMutex};
+                tieredFns[f.getName()] = move(bitcode);
+            }
+            instrument(f);
         }
         return m;
     }
 
-    JITSymbol JIT::findSymbol(const string name){
+    void JIT::instrument(Function &f){
+        Module *m = f.getParent();
+        auto &ctxt = m->getContext();
+        auto *i64 = Type::getInt64Ty(ctxt);
+
+        auto *counter = new GlobalVariable(*m, i64, false, GlobalValue::InternalLinkage,
+                ConstantInt::get(i64, 0), f.getName() + "$calls");
+
+        //count calls after the entry block's allocas so they remain static
+        auto insertPt = f.getEntryBlock().getFirstInsertionPt();
+        while(isa<AllocaInst>(*insertPt))
+            ++insertPt;
+
+        IRBuilder<> builder{&*insertPt};
+        auto *count = builder.CreateAdd(builder.CreateLoad(counter), ConstantInt::get(i64, 1));
+        builder.CreateStore(count, counter);
+
+        auto *isHot = builder.CreateICmpEQ(count, ConstantInt::get(i64, hotCallThreshold));
+        auto *thenTerm = SplitBlockAndInsertIfThen(isHot, &*builder.GetInsertPoint(), false);
+
+        //Both symbols are resolved to this JIT by createResolver
+        auto *ptrTy = Type::getInt8PtrTy(ctxt);
+        auto *hookTy = FunctionType::get(Type::getVoidTy(ctxt), {ptrTy, ptrTy}, false);
+        auto *hook = m->getOrInsertFunction("AnteJIT_onHotFunction", hookTy);
+        auto *self = m->getOrInsertGlobal("AnteJIT_instance", Type::getInt8Ty(ctxt));
+
+        //The function is identified by name rather than by an id assigned in this
+        //process so that the instrumented code, and thus its cached object, is
+        //the same in every run
+        builder.SetInsertPoint(thenTerm);
+        auto *name = builder.CreateGlobalStringPtr(f.getName());
+        builder.CreateCall(hook, {self, name});
+    }
+
+    void JIT::onHotFunction(JIT *jit, const char *name){
+        {
+            lock_guard<mutex> lock{jit->tierMutex};
+            jit->hotFns.push_back(name);
+            if(!jit->optimizer.joinable())
+                jit->optimizer = thread{&JIT::optimizeHotFunctions, jit};
+        }
+        jit->tierCv.notify_one();
+
+        //This runs inside JIT-compiled code, which may itself be in the middle
+        //of being linked, so the optimized body is only linked in the next
+        //time the JIT is entered through addModule or getSymbolAddress.
+    }
+
+    /*
+     * Each function is parsed into its own LLVMContext and compiled with
+     * optTm so that nothing here is shared with the main thread.
+     */
+    void JIT::optimizeHotFunctions(){
+        while(true){
+            string name, bitcode;
+            {
+                unique_lock<mutex> lock{tierMutex};
+                tierCv.wait(lock, [this]{ return stopping or !hotFns.empty(); });
+                if(stopping)
+                    return;
+
+                name = hotFns.front();
+                hotFns.pop_front();
+
+                //the function's module may have been removed since it became hot
+                auto it = tieredFns.find(name);
+                if(it == tieredFns.end())
+                    continue;
+
+                bitcode = move(it->second);
+                tieredFns.erase(it);
+            }
+
+            LLVMContext ctxt;
+            auto mod = parseBitcodeFile(MemoryBufferRef(bitcode, name), ctxt);
+            if(!mod){
+                consumeError(mod.takeError());
+                continue;
+            }
+
+            PassManagerBuilder pmb;
+            pmb.OptLevel = 2;
+
+            legacy::FunctionPassManager fpm{mod->get()};
+            legacy::PassManager pm;
+            pmb.populateFunctionPassManager(fpm);
+            pmb.populateModulePassManager(pm);
+
+            fpm.doInitialization();
+            for(auto &f : **mod)
+                fpm.run(f);
+            fpm.doFinalization();
+            pm.run(**mod);
+
+            //the -O0 body is still linked in under the original name
+            (*mod)->getFunction(name)->setName(name + "$opt");
+
+            auto obj = make_shared<object::OwningBinary<object::ObjectFile>>(SimpleCompiler(*optTm, optCache.get())(**mod));
+
+            lock_guard<mutex> lock{tierMutex};
+            optimizedFns.push_back({name, obj});
+        }
+    }
+
+    void JIT::linkOptimizedFunctions(){
+        vector<OptimizedFunction> ready;
+        {
+            lock_guard<mutex> lock{tierMutex};
+            ready.swap(optimizedFns);
+        }
+
+        for(auto &of : ready){
+            //the function's module was removed while it was being optimized
+            if(!findSymbol(of.name))
+                continue;
+
+            auto handle = objectLayer.addObject(of.obj, createResolver());
+            if(!handle){
+                consumeError(handle.takeError());
+                continue;
+            }
+            optimizedObjects[of.name] = *handle;
+
+            auto addr = objectLayer.findSymbolIn(*handle, mangle(of.name + "$opt"), false).getAddress();
+            if(!addr){
+                consumeError(addr.takeError());
+                continue;
+            }
+
+            //callers always go through the function's stub so they all
+            //use the optimized body from now on
+            if(auto err = codLayer.updatePointer(of.name, *addr))
+                consumeError(move(err));
+        }
+    }
+
+    string JIT::mangle(const string &name) const{
         string mangledName;
         raw_string_ostream mangledNameStream(mangledName);
         Mangler::getNameWithPrefix(mangledNameStream, name, dl);
-        return codLayer.findSymbol(mangledNameStream.str(), true);
+        return mangledNameStream.str();
+    }
+
+    JITSymbol JIT::findSymbol(const string name){
+        return codLayer.findSymbol(mangle(name), true);
     }
 
     JITTargetAddress JIT::getSymbolAddress(const string name){
+        linkOptimizedFunctions();
         return cantFail(findSymbol(name).getAddress());
     }
 
@@ -56,6 +237,110 @@ namespace ante {
         cantFail(codLayer.removeModule(h));
     }
 
+    bool JIT::hoistGlobal(GlobalVariable &g){
+        auto *init = g.getInitializer();
+        if(!isa<ConstantData>(init))
+            return false;
+
+        unique_ptr<Module> m{new Module(g.getName(), g.getContext())};
+        m->setDataLayout(dl);
+        m->setTargetTriple(g.getParent()->getTargetTriple());
+        new GlobalVariable(*m, g.getValueType(), g.isConstant(),
+                GlobalValue::ExternalLinkage, init, g.getName());
+        addModule(move(m));
+
+        g.setInitializer(nullptr);
+        g.setLinkage(GlobalValue::ExternalLinkage);
+        return true;
+    }
+
+    /*
+     * Lambdas are named by the order they are compiled in within each
+     * module, so the same name may refer to different functions in two modules.
+     */
+    bool isModuleSpecific(GlobalValue &gv){
+        return gv.getName().startswith("__lambda");
+    }
+
+    void JIT::prepareModule(Module &m, ArrayRef<GlobalValue*> specialized, bool temporary){
+        //When objects are cached the suffix is derived from the module's contents
+        //rather than the order modules are added in so that the renamed definitions,
+        //and thus the keys of their cached objects, are the same in every run.
+        //Otherwise hashing the module is not worth its cost and a counter is used.
+        string base = baseCache
+            ? "$" + hashPartition(&m, 0, "").substr(0, 16)
+            : "$" + to_string(usedSuffixes.size());
+        string suffix = base;
+        for(unsigned int i = 1; !usedSuffixes.insert(suffix).second; i++)
+            suffix = base + "." + to_string(i);
+
+        auto prepare = [&](GlobalValue &gv){
+            if(gv.isDeclaration() or !gv.hasName() or gv.hasLocalLinkage())
+                return false;
+
+            if(is_contained(specialized, &gv) or isModuleSpecific(gv)){
+                gv.setName(gv.getName().str() + suffix);
+                return false;
+            }
+
+            //link against the definition compiled by a previous module
+            if(findSymbol(gv.getName()))
+                return true;
+
+            //nothing may come to depend on a module that is about to be removed,
+            //global variables are instead moved out of it to be shared by later modules
+            if(temporary){
+                auto *g = dyn_cast<GlobalVariable>(&gv);
+                if(!g or !hoistGlobal(*g))
+                    gv.setName(gv.getName().str() + suffix);
+            }
+            return false;
+        };
+
+        for(auto &f : m)
+            if(prepare(f))
+                f.deleteBody();
+
+        for(auto &g : m.globals()){
+            if(prepare(g)){
+                g.setInitializer(nullptr);
+                g.setLinkage(GlobalValue::ExternalLinkage);
+            }
+        }
+    }
+
+    JIT::ModuleHandle JIT::addTemporaryModule(std::unique_ptr<Module> m){
+        vector<string> fns;
+        for(auto &f : *m)
+            if(!f.isDeclaration())
+                fns.push_back(f.getName());
+
+        auto handle = addModule(move(m));
+        temporaryModules.push_back({handle, move(fns)});
+        return handle;
+    }
+
+    void JIT::removeTemporaryModules(){
+        for(auto &tmpMod : temporaryModules){
+            removeModule(tmpMod.handle);
+
+            {
+                lock_guard<mutex> lock{tierMutex};
+                for(auto &name : tmpMod.fns)
+                    tieredFns.erase(name);
+            }
+
+            for(auto &name : tmpMod.fns){
+                auto it = optimizedObjects.find(name);
+                if(it != optimizedObjects.end()){
+                    cantFail(objectLayer.removeObject(it->second));
+                    optimizedObjects.erase(it);
+                }
+            }
+        }
+        temporaryModules.clear();
+    }
+
     void JIT::handleUnrecognizedFn(){
         cerr << "JIT Error: Unrecognized function called, aborting!" << endl;
     }
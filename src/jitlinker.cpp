@@ -14,64 +14,19 @@ using namespace ante::parser;
 namespace ante {
 
 /*
- * Returns a new module containing shallow copies of the given module's
- * traits. Copies the FuncDecls and UserTypes one level deeper so that
- * when the FuncDecl is marked as compiled the change is not performed
- * across every Compiler instance that imported the function.
+ * Gives dest a copy-on-write view of each of src's modules.
+ * Nothing is copied up front; FuncDecls are only copied into a
+ * view when dest first uses them so that when they are marked as
+ * compiled the change is not made across every Compiler instance
+ * that imported the function.
  */
-ante::Module* copyModuleFuncDecls(const ante::Module *mod){
-    auto ret = new ante::Module();
-    ret->name = mod->name;
-    ret->traits = mod->traits;
-
-    //copy each userType except for the LLVMContext-specific llvmTypes field
-    for(auto &pair : mod->userTypes){
-        auto dt = pair.second;
-    //    auto dt_cpy = make_shared<AnDataType>(dt->name, dt->fields, dt);
-    //    dt_cpy->traitImpls = dt->traitImpls;
-    //    dt_cpy->tags = dt->tags;
-    //    dt_cpy->generics = dt->generics;
-    //    dt_cpy->llvmType = dt->llvmType;
-        ret->userTypes[pair.first()] = dt;
-    }
-
-    for(auto &pair : mod->fnDecls){
-        for(auto &fd : pair.second){
-            auto fd_cpy = make_shared<FuncDecl>(fd->fdn, fd->mangledName, fd->scope, ret);
-            fd_cpy->obj = fd->obj;
-            fd_cpy->obj_bindings = fd->obj_bindings;
-            ret->fnDecls[pair.first()].push_back(fd_cpy);
-        }
-    }
-
-    return ret;
-}
-
-vector<ante::Module*>
-copyModuleFuncDecls(const vector<ante::Module*> &mods){
-    vector<ante::Module*> ret;
-    for(auto &m : mods){
-        ret.push_back(copyModuleFuncDecls(m));
-    }
-    return ret;
-}
-
-
-llvm::StringMap<ante::Module*>
-copyModuleFuncDecls(const llvm::StringMap<ante::Module*> &varTable){
-    auto ret = llvm::StringMap<ante::Module*>();
-    for(auto &pair : varTable){
-        ret[pair.first()] = copyModuleFuncDecls(pair.second);
-    }
-    return ret;
-}
-
 void copyDecls(const Compiler *src, Compiler *dest){
-    //dest->ctxt = src->ctxt;
+    dest->compUnit = new ante::Module(src->compUnit);
+    dest->mergedCompUnits = new ante::Module(src->mergedCompUnits);
 
-    dest->compUnit = copyModuleFuncDecls(src->compUnit);
-    dest->mergedCompUnits = copyModuleFuncDecls(src->mergedCompUnits);
-    dest->imports = copyModuleFuncDecls(src->imports);
+    dest->imports.clear();
+    for(auto *mod : src->imports)
+        dest->imports.push_back(new ante::Module(mod));
 }
 
 /*
@@ -135,27 +90,6 @@ void appendModifiers(Node *n, shared_ptr<Node> &mods){
 }
 
 
-void declareTypes(Compiler *c){
-    for(auto &p : c->mergedCompUnits->userTypes){
-        string tyName = p.first();
-        //auto *dt = c->lookupType(tyName);
-        //if(!dt) continue;
-
-        //vector<Type*> fields;
-        //TypeNode *fieldNodes = dt->tyn.get();
-        //if(dt->tyn->type == TT_Tuple or dt->tyn->type == TT_TaggedUnion)
-        //    fieldNodes = fieldNodes->extTy.get();
-
-        //while(fieldNodes){
-        //    fields.push_back(c->typeNodeToLlvmType(fieldNodes));
-        //    fieldNodes = (TypeNode*)fieldNodes->next.get();
-        //}
-
-        //StructType::create(*c->ctxt, fields, tyName);
-    }
-}
-
-
 void copyGlobals(Compiler *c, Compiler *ccpy){
     for(auto &g : c->module->getGlobalList()){
         if(g.getName() != "argc" and g.getName() != "argv"){
@@ -180,7 +114,6 @@ unique_ptr<Compiler> wrapFnInModule(Compiler *c, string const& baseName,
     ccpy->isJIT = true;
 
     copyDecls(c, ccpy.get());
-    declareTypes(ccpy.get());
     //copyGlobals(c, ccpy.get());
 
     //create an empty main function to avoid crashes with compFn when
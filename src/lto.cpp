@@ -0,0 +1,150 @@
+/*
+ *      lto.cpp
+ * Drives ThinLTO over each Ante module along with any
+ * bitcode (eg. from clang -flto=thin) given on the command line.
+ */
+#include <llvm/LTO/LTO.h>
+#include <llvm/LTO/Caching.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Transforms/IPO.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <iostream>
+#include <mutex>
+
+#include "compiler.h"
+#include "target.h"
+
+using namespace std;
+using namespace llvm;
+
+namespace ante {
+
+//Defined in compiler.cpp
+TargetMachine* getTargetMachine();
+
+/**
+ * Writes the given module as bitcode containing a ThinLTO summary
+ */
+unique_ptr<MemoryBuffer> writeThinLTOBitcode(llvm::Module *mod, string const& name){
+    SmallVector<char, 0> buf;
+    raw_svector_ostream os{buf};
+
+    legacy::PassManager pm;
+    pm.add(createWriteThinLTOBitcodePass(os));
+    pm.run(*mod);
+
+    return MemoryBuffer::getMemBufferCopy(StringRef(buf.data(), buf.size()), name);
+}
+
+
+/**
+ * Adds the bitcode file in buf to the link, resolving each symbol
+ * it defines to the first definition seen of that symbol.
+ *
+ * @return 0 on success
+ */
+int addLTOInput(lto::LTO &lto, MemoryBuffer *buf, StringMap<bool> &defined, bool isLib){
+    auto input = lto::InputFile::create(buf->getMemBufferRef());
+    if(!input){
+        logAllUnhandledErrors(input.takeError(), errs(), "Error when reading " + buf->getBufferIdentifier() + ": ");
+        return 1;
+    }
+
+    vector<lto::SymbolResolution> resolutions;
+    for(auto &sym : (*input)->symbols()){
+        lto::SymbolResolution res;
+        if(!sym.isUndefined()){
+            res.Prevailing = defined.insert({sym.getName(), true}).second;
+            res.FinalDefinitionInLinkageUnit = true;
+
+            //Only main is called from outside of the linked bitcode unless
+            //this is a library, everything else is free to be internalized.
+            res.VisibleToRegularObj = isLib or sym.getName() == "main";
+        }
+        resolutions.push_back(res);
+    }
+
+    if(auto err = lto.add(move(*input), resolutions)){
+        logAllUnhandledErrors(move(err), errs(), "Error when adding " + buf->getBufferIdentifier() + ": ");
+        return 1;
+    }
+    return 0;
+}
+
+
+int Compiler::compileWithThinLTO(llvm::Module *mod, vector<string> const& bitcodeFiles,
+        string outFile, vector<string> &objFiles){
+
+    auto *tm = getTargetMachine();
+    auto dataLayout = tm->createDataLayout();
+    delete tm;
+
+    vector<unique_ptr<MemoryBuffer>> buffers;
+
+    //each ante::Module is its own ThinLTO module so that small functions
+    //from the stdlib can still be imported and inlined across them
+    unsigned int i = 0;
+    for(auto &part : splitByAnteModule(this, mod)){
+        part->setTargetTriple(AN_TARGET_TRIPLE);
+        part->setDataLayout(dataLayout);
+        buffers.push_back(writeThinLTOBitcode(part.get(), outFile + ".part" + to_string(i++) + ".bc"));
+    }
+
+    for(auto &file : bitcodeFiles){
+        auto buf = MemoryBuffer::getFile(file);
+        if(!buf){
+            cerr << "Error when opening " << file << ": " << buf.getError().message() << endl;
+            return 1;
+        }
+        buffers.push_back(move(*buf));
+    }
+
+    lto::Config conf;
+    conf.RelocModel = Reloc::Model::PIC_;
+    conf.OptLevel = optLvl;
+    conf.CGOptLevel = optLvl == 0 ? CodeGenOpt::Level::None : CodeGenOpt::Level::Aggressive;
+
+    lto::LTO lto{move(conf), lto::createInProcessThinBackend(codegenThreads)};
+
+    StringMap<bool> defined;
+    for(auto &buf : buffers)
+        if(addLTOInput(lto, buf.get(), defined, isLib))
+            return 1;
+
+    //Backends run in parallel and may request their output streams concurrently
+    mutex objFilesMutex;
+    bool failed = false;
+
+    auto addStream = [&](unsigned task) -> unique_ptr<lto::NativeObjectStream> {
+        string objFile = outFile + ".lto" + to_string(task) + ".o";
+
+        std::error_code errCode;
+        auto out = llvm::make_unique<raw_fd_ostream>(objFile, errCode, sys::fs::OpenFlags::F_None);
+
+        lock_guard<mutex> lock{objFilesMutex};
+        if(errCode){
+            cerr << "Error when opening " << objFile << ": " << errCode.message() << endl;
+            failed = true;
+
+            //a raw_fd_ostream that failed to open reports a fatal error when
+            //destroyed, so discard this task's output instead
+            out->clear_error();
+            return llvm::make_unique<lto::NativeObjectStream>(
+                    llvm::make_unique<raw_null_ostream>());
+        }
+        objFiles.push_back(objFile);
+        return llvm::make_unique<lto::NativeObjectStream>(move(out));
+    };
+
+    if(auto err = lto.run(addStream)){
+        logAllUnhandledErrors(move(err), errs(), "Error during ThinLTO: ");
+        return 1;
+    }
+    return failed;
+}
+
+} //end of namespace ante
@@ -1,5 +1,9 @@
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ExecutionEngine/GenericValue.h>
 #include <llvm/ExecutionEngine/Interpreter.h>
 #include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/IR/CFG.h>
+#include <cstdio>
 #include "compiler.h"
 #include "types.h"
 #include "function.h"
@@ -257,35 +261,8 @@ TypedValue createUnionVariantCast(Compiler *c, TypedValue &valToCast, string &ta
         unionDataTy = (AnDataType*)bindGenericToType(c, unionDataTy, tyeq->bindings);
     }
 
-    Type *variantTy = c->anTypeToLlvmType(valToCast.type);
-
     auto tagVal = unionDataTy->getTagVal(tagName);
-
-    vector<Type*> unionTys;
-    unionTys.push_back(Type::getInt8Ty(*c->ctxt));
-    unionTys.push_back(variantTy);
-
-    vector<Constant*> unionVals;
-    unionVals.push_back(ConstantInt::get(*c->ctxt, APInt(8, tagVal, true))); //tag
-    unionVals.push_back(UndefValue::get(variantTy));
-
-    Type *unionTy = c->anTypeToLlvmType(unionDataTy);
-
-    //create a struct of (u8 tag, <union member type>)
-    auto *uninitUnion = ConstantStruct::get(StructType::get(*c->ctxt, unionTys, true), unionVals);
-    auto* taggedUnion = c->builder.CreateInsertValue(uninitUnion, valToCast.val, 1);
-
-    //allocate for the largest possible union member
-    auto *alloca = c->builder.CreateAlloca(unionTy);
-
-    //but bitcast it the the current member
-    auto *castTo = c->builder.CreateBitCast(alloca, taggedUnion->getType()->getPointerTo());
-    c->builder.CreateStore(taggedUnion, castTo);
-
-    //load the original alloca, not the bitcasted one
-    Value *unionVal = c->builder.CreateLoad(alloca);
-
-    return TypedValue(unionVal, unionDataTy);
+    return createUnionValue(c, unionDataTy, tagVal, valToCast);
 }
 
 
@@ -688,9 +665,7 @@ TypedValue compIf(Compiler *c, IfNode *ifn, BasicBlock *mergebb, vector<pair<Typ
                 auto *ins = ri ? ri->getParent() : c->builder.GetInsertBlock();
                 c->builder.SetInsertPoint(ins);
 
-                auto *cast = c->builder.CreateBitCast(alloca, c->anTypeToLlvmType(generic.type)->getPointerTo());
-                auto *fixed_ret = c->builder.CreateLoad(cast);
-                generic.val = fixed_ret;
+                generic.val = loadAsType(c, alloca, generic.type);
                 if(ri) ri->eraseFromParent();
             }
         }
@@ -938,41 +913,186 @@ vector<Value*> unwrapVoidPtrArgs(Compiler *c, Value *anteCallArg, vector<TypedVa
 
 
 /**
- * Creates a function AnteCall that unpacks the given arguments from a void*,
- * and returns the result of a call to the given FuncDecl with those arguments.
+ * Returns true if the constant does not reference any global value
+ * and can thus be reused in any module.
+ */
+bool isModuleIndependent(Constant *c){
+    if(isa<GlobalValue>(c))
+        return false;
+
+    for(auto &op : c->operands())
+        if(!isModuleIndependent(cast<Constant>(op)))
+            return false;
+    return true;
+}
+
+
+/**
+ * Returns true if each argument can be passed to fd directly as a constant
+ * within the AnteCall driver rather than being packed into a void*.
+ */
+bool canPassArgsDirectly(FuncDecl *fd, vector<TypedValue> const& typedArgs){
+    auto *fnTy = cast<Function>(fd->tv.val)->getFunctionType();
+    if(typedArgs.size() < fnTy->getNumParams())
+        return false;
+
+    for(size_t i = 0; i < typedArgs.size(); i++){
+        Constant *arg = dyn_cast<Constant>(typedArgs[i].val);
+        if(!arg or !isModuleIndependent(arg))
+            return false;
+
+        if(i < fnTy->getNumParams() and arg->getType() != fnTy->getParamType(i))
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * Creates a function AnteCall that calls the given FuncDecl with the given arguments
+ * and stores the result in a buffer provided by the caller.
+ *
+ * AnteCall has the type i8*, i8* -> void.  If the arguments are all constants they are
+ * passed to fd directly and the first parameter is unused, otherwise the first parameter
+ * is a tuple of fd's parameter types to be unpacked within AnteCall.  The second parameter
+ * is a buffer large enough to hold fd's return value, if it has one.
  *
- * AnteCall has the type 't*->'u* where 't is a tuple of fd's parameter types (to
- * be unpacked within AnteCall) and 'u is the return type of fd.
+ * @return true if the arguments need to be packed into a void* to be given to AnteCall.
  */
-void createDriverFunction(Compiler *c, FuncDecl *fd, vector<TypedValue> const& typedArgs){
+bool createDriverFunction(Compiler *c, FuncDecl *fd, vector<TypedValue> const& typedArgs){
     Type *voidPtrTy = Type::getInt8Ty(*c->ctxt)->getPointerTo();
-    FunctionType *fnTy = FunctionType::get(voidPtrTy, voidPtrTy, false);
+    FunctionType *fnTy = FunctionType::get(Type::getVoidTy(*c->ctxt), {voidPtrTy, voidPtrTy}, false);
 
-    //preFn is the predecessor to fn because we do not yet know its return type, so its body must be compiled,
-    //then the type must be checked and the new function with correct return type created, and their bodies swapped.
     Function *fn = Function::Create(fnTy, Function::ExternalLinkage, "AnteCall", c->module.get());
     BasicBlock *entry = BasicBlock::Create(*c->ctxt, "entry", fn);
     c->builder.SetInsertPoint(entry);
 
-    auto *fnArg1 = fn->arg_begin();
-    auto args = unwrapVoidPtrArgs(c, fnArg1, typedArgs, fd);
+    auto *argsPtr = &*fn->arg_begin();
+    auto *retPtr = &*std::next(fn->arg_begin());
+
+    bool packArgs = !canPassArgsDirectly(fd, typedArgs);
+
+    vector<Value*> args;
+    if(packArgs){
+        args = unwrapVoidPtrArgs(c, argsPtr, typedArgs, fd);
+    }else{
+        for(auto &arg : typedArgs)
+            args.push_back(arg.val);
+    }
 
     Value *call = c->builder.CreateCall(fd->tv.val, args);
     AnType *retTy = fd->tv.type->getFunctionReturnType();
-    if(retTy->typeTag == TT_Void){
-        c->builder.CreateRetVoid();
-    }else{
-        auto callTv = TypedValue(call, fd->tv.type->getFunctionReturnType());
+    if(retTy->typeTag != TT_Void){
+        auto *typedRetPtr = c->builder.CreateBitCast(retPtr, call->getType()->getPointerTo());
+        c->builder.CreateStore(call, typedRetPtr);
+    }
+    c->builder.CreateRetVoid();
+    return packArgs;
+}
+
+CompilerCtCtxt::CompilerCtCtxt() = default;
+CompilerCtCtxt::~CompilerCtCtxt() = default;
+
+
+/**
+ * Gets the key a compile-time call's driver is cached under.
+ *
+ * The arguments of a compile-time call are substituted directly into the body
+ * of the function being called, so the compiled function is only reusable for
+ * calls with the same arguments.  Constants are uniqued within their LLVMContext
+ * so their addresses can be compared directly.
+ *
+ * @return false if the call cannot be cached because one of its arguments is
+ *         not a constant.
+ */
+bool getCtCallKey(string const& mangledName, vector<TypedValue> const& typedArgs, string &key){
+    key = mangledName;
+    for(auto &arg : typedArgs){
+        if(!isa<Constant>(arg.val))
+            return false;
 
-        auto store = createMallocAndStore(c, callTv);
-        auto ret = c->builder.CreateBitCast(store.val, voidPtrTy);
-        c->builder.CreateRet(ret);
+        key += "$" + to_string((uintptr_t)arg.val) + ":" + to_string((uintptr_t)arg.type);
     }
+    return true;
 }
 
-TypedValue compileAndCallAnteFunction(Compiler *c, string const& baseName,
-        string const& mangledName, vector<TypedValue> const& typedArgs){
 
+/**
+ * Compile-time functions with at most this many instructions in total
+ * (including any functions they call) and no loops are interpreted
+ * since generating machine code for them would take longer than running them.
+ */
+const size_t maxInterpretedInstructions = 256;
+
+/**
+ * Returns true if the module of a compile-time call is small and simple
+ * enough to be run by the interpreter rather than being compiled natively.
+ */
+bool shouldInterpret(llvm::Module *mod){
+    size_t instructions = 0;
+
+    for(auto &f : *mod){
+        //Calls to external functions are left to the JIT since the interpreter
+        //can only make them if LLVM was built with libffi.  Of the intrinsics
+        //only memcpy and memset are lowered by the interpreter itself.
+        if(f.isDeclaration()){
+            if(f.use_empty())
+                continue;
+
+            auto id = f.getIntrinsicID();
+            if(id != Intrinsic::memcpy and id != Intrinsic::memset)
+                return false;
+            continue;
+        }
+
+        //any branch to a block at or before the current one may be a loop
+        SmallPtrSet<BasicBlock*, 16> visited;
+        for(auto &bb : f){
+            visited.insert(&bb);
+            instructions += bb.size();
+
+            for(auto *succ : successors(&bb))
+                if(visited.count(succ))
+                    return false;
+
+            for(auto &inst : bb)
+                if(auto *call = dyn_cast<CallInst>(&inst))
+                    if(call->getCalledFunction() == &f)
+                        return false;
+        }
+
+        if(instructions > maxInterpretedInstructions)
+            return false;
+    }
+    return true;
+}
+
+
+void runCtCallDriver(CtCallDriver &driver, void *args, void *ret){
+    if(driver.interpreter){
+        vector<GenericValue> gvArgs{PTOGV(args), PTOGV(ret)};
+        driver.interpreter->runFunction(driver.interpretedFn, gvArgs);
+    }else{
+        driver.fn(args, ret);
+    }
+
+    //Compile-time code prints through the compiler's own stdio, write out
+    //anything it printed so that it appears in the order the calls are made
+    fflush(stdout);
+}
+
+
+/**
+ * Compiles the given compile-time function into the shared JIT
+ * and returns a driver that calls it with the given arguments.
+ *
+ * @param reusable false if the driver will only ever be run once,
+ *        eg. because its arguments are not constants
+ */
+CtCallDriver compileCtCallDriver(Compiler *c, string const& baseName,
+        string const& mangledName, vector<TypedValue> const& typedArgs, bool reusable){
+
+    size_t callsBefore = c->ctCtxt->ctCallsEvaluated;
     auto mod_compiler = wrapFnInModule(c, baseName, mangledName, typedArgs);
     mod_compiler->ast.release();
 
@@ -993,25 +1113,225 @@ TypedValue compileAndCallAnteFunction(Compiler *c, string const& baseName,
         throw new CtError();
     }
 
-    createDriverFunction(mod_compiler.get(), fd, typedArgs);
-    std::error_code ec;
+    bool packArgs = createDriverFunction(mod_compiler.get(), fd, typedArgs);
 
-    JIT* jit = new JIT();
-    jit->addModule(move(mod_compiler->module));
+    auto &jit = c->ctCtxt->jit;
+    if(!jit)
+        jit.reset(new JIT(c->ctCtxt->jitCacheDir));
 
-    auto fn = (void*(*)(void*))jit->getSymbolAddress("AnteCall");
-    if(fn){
-        auto arg = ArgTuple(c, typedArgs);
+    AnType *retTy = fd->tv.type->getFunctionReturnType();
+    size_t retSize = 0;
+    if(retTy->typeTag != TT_Void){
+        Type *llvmRetTy = cast<Function>(fd->tv.val)->getReturnType();
+        retSize = jit->getTargetMachine().createDataLayout().getTypeAllocSize(llvmRetTy);
+    }
+
+    auto *driver = mod_compiler->module->getFunction("AnteCall");
+
+    //Any compile-time calls made while compiling the function have their
+    //results baked into it, eg. Ante.lookup, so it must be recompiled next time.
+    bool temporary = !reusable or c->ctCtxt->ctCallsEvaluated != callsBefore;
+
+    if(shouldInterpret(mod_compiler->module.get())){
+        //the interpreter lays out memory with the module's DataLayout, which
+        //must match the host's for the arguments and result to be read correctly
+        mod_compiler->module->setDataLayout(jit->getTargetMachine().createDataLayout());
+
+        string err;
+        auto *interpreter = EngineBuilder(move(mod_compiler->module))
+            .setEngineKind(EngineKind::Interpreter)
+            .setErrorStr(&err)
+            .create();
 
-        auto res = fn(arg.asRawData());
-        auto *retTy = fd->tv.type->getFunctionReturnType();
-        return ArgTuple(c, res, retTy).asTypedValue();
+        if(!interpreter){
+            c->errFlag = true;
+            cerr << "Error when creating interpreter for " << baseName << ": " << err << endl;
+            throw new CtError();
+        }
+
+        c->ctCtxt->interpreters.emplace_back(interpreter);
+        return {nullptr, retTy, retSize, packArgs, temporary, interpreter, driver};
+    }
+
+    //Only the driver and the function it calls are specific to these arguments,
+    //everything else links against the copies compiled by previous calls.
+    auto *entry = cast<Function>(fd->tv.val);
+    jit->prepareModule(*mod_compiler->module, {driver, entry}, temporary);
+    string driverName = driver->getName();
+
+    if(temporary)
+        jit->addTemporaryModule(move(mod_compiler->module));
+    else
+        jit->addModule(move(mod_compiler->module));
+
+    auto fn = (void(*)(void*, void*))jit->getSymbolAddress(driverName);
+    return {fn, retTy, retSize, packArgs, temporary, nullptr, nullptr};
+}
+
+
+/**
+ * Frees a driver compiled for a single compile-time call once it has been run
+ */
+void releaseCtCallDriver(Compiler *c, CtCallDriver &driver){
+    if(driver.interpreter){
+        auto &interpreters = c->ctCtxt->interpreters;
+        for(auto it = interpreters.begin(); it != interpreters.end(); ++it){
+            if(it->get() == driver.interpreter){
+                interpreters.erase(it);
+                break;
+            }
+        }
+    }else if(c->ctCtxt->jit){
+        c->ctCtxt->jit->removeTemporaryModules();
+    }
+}
+
+
+TypedValue compileAndCallAnteFunction(Compiler *c, string const& baseName,
+        string const& mangledName, vector<TypedValue> const& typedArgs){
+
+    CtCallDriver driver;
+    string key;
+
+    if(getCtCallKey(mangledName, typedArgs, key)){
+        auto it = c->ctCtxt->ctCallDrivers.find(key);
+        if(it != c->ctCtxt->ctCallDrivers.end()){
+            driver = it->second;
+        }else{
+            driver = compileCtCallDriver(c, baseName, mangledName, typedArgs, true);
+            if(!driver.temporary)
+                c->ctCtxt->ctCallDrivers[key] = driver;
+        }
+    }else{
+        driver = compileCtCallDriver(c, baseName, mangledName, typedArgs, false);
+    }
+
+    TypedValue result = c->getVoidLiteral();
+    if(driver.fn or driver.interpreter){
+        //the result is converted to a TypedValue before returning so it
+        //only needs to live as long as this call
+        vector<uint64_t> res((driver.retSize + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+
+        if(driver.packArgs){
+            auto arg = ArgTuple(c, typedArgs);
+            runCtCallDriver(driver, arg.asRawData(), res.data());
+        }else{
+            runCtCallDriver(driver, nullptr, res.data());
+        }
+
+        if(driver.retTy->typeTag != TT_Void)
+            result = ArgTuple(c, res.data(), driver.retTy).asTypedValue();
     }else{
         cerr << "(null)" << endl;
-        return c->getVoidLiteral();
     }
+
+    if(driver.temporary)
+        releaseCtCallDriver(c, driver);
+    return result;
+}
+
+/**
+ * Returns true if the given function is marked with the !pure compiler directive.
+ */
+bool isPureFunction(FuncDecl *fd){
+    for(auto *mod = fd->fdn->modifiers.get(); mod; mod = (ModNode*)mod->next.get()){
+        if(!mod->isCompilerDirective())
+            continue;
+
+        if(VarNode *vn = dynamic_cast<VarNode*>(mod->expr.get()))
+            if(vn->name == "pure")
+                return true;
+    }
+    return false;
+}
+
+
+/**
+ * Appends a structural encoding of the given constant to key.  Two constants
+ * have the same encoding iff they are structurally equal, looking through
+ * constant globals such as string literals to their contents.
+ *
+ * @return false if the constant depends on mutable state, eg. a global variable.
+ */
+bool appendConstantKey(Constant *c, string &key){
+    if(ConstantInt *ci = dyn_cast<ConstantInt>(c)){
+        key += "i" + to_string(ci->getBitWidth()) + ":" + ci->getValue().toString(16, false);
+    }else if(ConstantFP *cf = dyn_cast<ConstantFP>(c)){
+        key += "f" + cf->getValueAPF().bitcastToAPInt().toString(16, false);
+    }else if(ConstantDataSequential *cds = dyn_cast<ConstantDataSequential>(c)){
+        auto raw = cds->getRawDataValues();
+        key += "d" + to_string(raw.size()) + ":" + raw.str();
+    }else if(isa<ConstantPointerNull>(c)){
+        key += "null";
+    }else if(isa<UndefValue>(c)){
+        key += "undef";
+    }else if(isa<ConstantAggregateZero>(c)){
+        key += "zero";
+    }else if(Function *f = dyn_cast<Function>(c)){
+        key += "fn:" + f->getName().str();
+    }else if(GlobalVariable *gv = dyn_cast<GlobalVariable>(c)){
+        if(!gv->isConstant() or !gv->hasInitializer())
+            return false;
+
+        key += "g(";
+        if(!appendConstantKey(gv->getInitializer(), key))
+            return false;
+        key += ")";
+    }else if(isa<ConstantAggregate>(c) or isa<ConstantExpr>(c)){
+        if(ConstantExpr *ce = dyn_cast<ConstantExpr>(c))
+            key += "e" + to_string(ce->getOpcode());
+
+        key += "{";
+        for(auto &op : c->operands()){
+            if(!appendConstantKey(cast<Constant>(op), key))
+                return false;
+            key += ",";
+        }
+        key += "}";
+    }else{
+        return false;
+    }
+    return true;
 }
 
+
+/**
+ * Calls a compile-time function marked !pure, reusing the result of a
+ * previous call with structurally equal arguments if there was one.
+ */
+TypedValue callPureAnteFunction(Compiler *c, string const& baseName,
+        string const& mangledName, vector<TypedValue> const& typedArgs){
+
+    string key = mangledName;
+    bool cacheable = true;
+
+    for(auto &arg : typedArgs){
+        Constant *constArg = dyn_cast<Constant>(arg.val);
+        key += ";" + anTypeToStr(arg.type) + "=";
+
+        if(!constArg or !appendConstantKey(constArg, key)){
+            cacheable = false;
+            break;
+        }
+    }
+
+    if(!cacheable)
+        return compileAndCallAnteFunction(c, baseName, mangledName, typedArgs);
+
+    auto it = c->ctCtxt->pureCallResults.find(key);
+    if(it != c->ctCtxt->pureCallResults.end())
+        return it->second;
+
+    auto res = compileAndCallAnteFunction(c, baseName, mangledName, typedArgs);
+
+    Constant *constRes = dyn_cast_or_null<Constant>(res.val);
+    if(constRes and isModuleIndependent(constRes))
+        c->ctCtxt->pureCallResults[key] = res;
+
+    return res;
+}
+
+
 /*
  *  Compile a compile-time function/macro which should not return a function call,
  *  just a compile-time constant.
@@ -1024,41 +1344,23 @@ TypedValue compileAndCallAnteFunction(Compiler *c, string const& baseName,
 TypedValue compMetaFunctionResult(Compiler *c, LOC_TY const& loc, string const& baseName,
         string const& mangledName, vector<TypedValue> const& typedArgs){
 
+    c->ctCtxt->ctCallsEvaluated++;
+
     CtFunc* fn;
     if(!(fn = compapi[baseName].get())){
+        auto *fd = c->getFuncDecl(baseName, mangledName);
+        if(fd and isPureFunction(fd))
+            return callPureAnteFunction(c, baseName, mangledName, typedArgs);
+
         return compileAndCallAnteFunction(c, baseName, mangledName, typedArgs);
     }
 
     //fn was found, this is a builtin compiler api function
-    TypedValue *res;
-
     if(typedArgs.size() != fn->params.size())
         return c->compErr("Called function was given " + to_string(typedArgs.size()) +
                 " argument(s) but was declared to take " + to_string(fn->params.size()), loc);
 
-    /* alias typedArgs for switch statement */
-    vector<TypedValue> const& ta = typedArgs;
-
-    switch(fn->params.size()){
-        case 0: res = (*fn)(c); break;
-        case 1: res = (*fn)(c, ta[0]); break;
-        case 2: res = (*fn)(c, ta[0], ta[1]); break;
-        case 3: res = (*fn)(c, ta[0], ta[1], ta[2]); break;
-        case 4: res = (*fn)(c, ta[0], ta[1], ta[2], ta[3]); break;
-        case 5: res = (*fn)(c, ta[0], ta[1], ta[2], ta[3], ta[4]); break;
-        case 6: res = (*fn)(c, ta[0], ta[1], ta[2], ta[3], ta[4], ta[5]); break;
-        default:
-            cerr << "CtFuncs with more than 6 parameters are unimplemented." << endl;
-            return {};
-    }
-
-    if(res){
-        TypedValue ret = *res;
-        delete res;
-        return ret;
-    }else{
-        return c->getVoidLiteral();
-    }
+    return (*fn)(c, typedArgs);
 }
 
 
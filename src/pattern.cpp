@@ -1,3 +1,4 @@
+#include <llvm/ADT/SmallSet.h>
 #include "pattern.h"
 #include "types.h"
 
@@ -102,19 +103,35 @@ namespace ante {
         return ty;
     }
 
-    Type* getUnionVariantType(Compiler *c, AnDataType *tagTy){
+    Type* getUnionVariantType(Compiler *c, AnDataType *unionTy, AnDataType *tagTy){
         AnType *anTagData = unionVariantToTupleTy(tagTy);
         Type *tagData = c->anTypeToLlvmType(anTagData);
+        Type *tag = getUnionTagType(c, unionTy);
         return tagData->isVoidTy() ?
-            StructType::get(*c->ctxt, {c->builder.getInt8Ty()}, true) :
-            StructType::get(*c->ctxt, {c->builder.getInt8Ty(), tagData}, true);
+            StructType::get(*c->ctxt, {tag}, true) :
+            StructType::get(*c->ctxt, {tag, tagData}, true);
     }
 
     TypedValue unionDowncast(Compiler *c, TypedValue valToMatch, AnDataType *tagTy){
+        auto *unionTy = (AnDataType*)valToMatch.type;
+        AnType *tagData = unionVariantToTupleTy(tagTy);
+
+        //niche layouts store the non-empty variant's value directly
+        auto layout = getUnionLayout(unionTy);
+        if(layout != UnionLayout::Tagged){
+            if(tagData->typeTag == TT_Void)
+                return c->getVoidLiteral();
+
+            Value *field = c->builder.CreateExtractValue(valToMatch.val, 0);
+            if(layout == UnionLayout::Bool)
+                field = c->builder.CreateTrunc(field, c->builder.getInt1Ty());
+            return {field, tagData};
+        }
+
         auto alloca = addrOf(c, valToMatch);
 
         //bitcast valToMatch* to (tag, tagData)*
-        auto *castTy = getUnionVariantType(c, tagTy);
+        auto *castTy = getUnionVariantType(c, unionTy, tagTy);
 
         if(castTy->getStructNumElements() != 1){
             auto *cast = c->builder.CreateBitCast(alloca.val, castTy->getPointerTo());
@@ -122,22 +139,17 @@ namespace ante {
             //extract tag_data from (tag, tagData)*
             auto *gep = c->builder.CreateStructGEP(castTy, cast, 1);
             auto *deref = c->builder.CreateLoad(gep);
-            return {deref, unionVariantToTupleTy(tagTy)};
+            return {deref, tagData};
         }else{
             return c->getVoidLiteral();
         }
     }
 
     /**
-     * Match a union variant pattern, eg. Some x or None
-     * @param pattern The type to match against, eg. Some
-     * @param bindExpr The optional expr to bind params to, eg. x
+     * Returns the union tag type named by a variant pattern, eg. Some,
+     * after checking it can be matched against valToMatch.
      */
-    void match_variant(CompilingVisitor &cv, MatchNode *n, TypeNode *pattern,
-            Node *bindExpr, BasicBlock *jmpOnFail, TypedValue &valToMatch){
-
-        Compiler *c = cv.c;
-
+    AnDataType* getVariantPatternType(Compiler *c, TypeNode *pattern, TypedValue &valToMatch){
         auto *tagTy = AnDataType::get(pattern->typeName);
         if(!tagTy or tagTy->isStub())
             c->compErr("No type " + typeNodeToColoredStr(pattern)
@@ -148,9 +160,6 @@ namespace ante {
                     + " must be a union tag to be used in a pattern", pattern->loc);
 
         auto *parentTy = tagTy->parentUnionType;
-        ConstantInt *ci = ConstantInt::get(*c->ctxt,
-                APInt(8, parentTy->getTagVal(pattern->typeName), true));
-
         tagTy = (AnDataType*)bindGenericToType(c, tagTy, ((AnDataType*)valToMatch.type)->boundGenerics);
         tagTy = tagTy->setModifier(valToMatch.type->mods);
 
@@ -161,35 +170,71 @@ namespace ante {
             c->compErr("Cannot bind pattern of type " + anTypeToColoredStr(parentTy) +
                     " to matched value of type " + anTypeToColoredStr(valToMatch.type), pattern->loc);
 
-        //Extract tag value and check for equality
-        Value *eq;
+        return tagTy;
+    }
+
+    /**
+     * Returns the tag value of the variant named by pattern.
+     * Assumes getVariantPatternType has already checked pattern.
+     */
+    unsigned short getVariantTag(TypeNode *pattern){
+        auto *tagTy = AnDataType::get(pattern->typeName);
+        return tagTy->parentUnionType->getTagVal(pattern->typeName);
+    }
+
+    /**
+     * Extracts the tag of a tagged union, computing it
+     * from the union's value if it uses a niche layout.
+     */
+    Value* getUnionTag(Compiler *c, TypedValue &valToMatch){
+        return extractUnionTag(c, valToMatch);
+    }
+
+    /**
+     * Binds the contents of a union variant to bindExpr, assuming
+     * valToMatch's tag is already known to be that of tagTy.
+     */
+    void bind_variant(CompilingVisitor &cv, MatchNode *n, AnDataType *tagTy,
+            Node *bindExpr, BasicBlock *jmpOnFail, TypedValue &valToMatch){
+
+        Compiler *c = cv.c;
+
+        TypedValue variant;
         if(valToMatch.getType()->isStructTy()){
-            Value *tagVal = c->builder.CreateExtractValue(valToMatch.val, 0);
-            eq = c->builder.CreateICmpEQ(tagVal, ci);
+            variant = unionDowncast(c, valToMatch, tagTy);
         }else if(valToMatch.getType()->isIntegerTy()){
-            eq = c->builder.CreateICmpEQ(valToMatch.val, ci);
+            variant = c->getVoidLiteral();
         }else{
             //all tagged unions are either just their tag (enum) or a tag and value.
             assert_unreachable();
         }
+        handlePattern(cv, n, bindExpr, jmpOnFail, variant);
+    }
+
+    /**
+     * Match a union variant pattern, eg. Some x or None
+     * @param pattern The type to match against, eg. Some
+     * @param bindExpr The optional expr to bind params to, eg. x
+     */
+    void match_variant(CompilingVisitor &cv, MatchNode *n, TypeNode *pattern,
+            Node *bindExpr, BasicBlock *jmpOnFail, TypedValue &valToMatch){
+
+        Compiler *c = cv.c;
+
+        auto *tagTy = getVariantPatternType(c, pattern, valToMatch);
+
+        //Extract tag value and check for equality
+        Value *tagVal = getUnionTag(c, valToMatch);
+        auto *ci = ConstantInt::get(tagVal->getType(), getVariantTag(pattern));
+        Value *eq = c->builder.CreateICmpEQ(tagVal, ci);
 
         BasicBlock *jmpOnSuccess = BasicBlock::Create(*cv.c->ctxt, "match", getCurFunction(cv.c));
         c->builder.CreateCondBr(eq, jmpOnSuccess, jmpOnFail);
         c->builder.SetInsertPoint(jmpOnSuccess);
 
         //bind any identifiers and match remaining pattern
-        if(bindExpr){
-            TypedValue variant;
-            if(valToMatch.getType()->isStructTy()){
-                variant = unionDowncast(c, valToMatch, tagTy);
-            }else if(valToMatch.getType()->isIntegerTy()){
-                variant = c->getVoidLiteral();
-            }else{
-                //all tagged unions are either just their tag (enum) or a tag and value.
-                assert_unreachable();
-            }
-            handlePattern(cv, n, bindExpr, jmpOnFail, variant);
-        }
+        if(bindExpr)
+            bind_variant(cv, n, tagTy, bindExpr, jmpOnFail, valToMatch);
     }
 
     void handlePattern(CompilingVisitor &cv, MatchNode *n, Node *pattern,
@@ -210,6 +255,9 @@ namespace ante {
         }else if(IntLitNode *iln = dynamic_cast<IntLitNode*>(pattern)){
             match_literal(cv, n, pattern, jmpOnFail, valToMatch, Int);
 
+        }else if(dynamic_cast<BoolLitNode*>(pattern)){
+            match_literal(cv, n, pattern, jmpOnFail, valToMatch, Int);
+
         }else if(FltLitNode *fln = dynamic_cast<FltLitNode*>(pattern)){
             match_literal(cv, n, pattern, jmpOnFail, valToMatch, Flt);
 
@@ -222,6 +270,346 @@ namespace ante {
     }
 
 
+    /**
+     * Returns the variant pattern at the root of pattern, eg. Some in Some x,
+     * along with the expression its contents are bound to, if any.
+     */
+    TypeNode* getVariantPattern(Node *pattern, Node *&bindExpr){
+        if(TypeCastNode *tcn = dynamic_cast<TypeCastNode*>(pattern)){
+            bindExpr = tcn->rval.get();
+            return tcn->typeExpr.get();
+        }
+        bindExpr = nullptr;
+        return dynamic_cast<TypeNode*>(pattern);
+    }
+
+    bool isCatchAllPattern(Node *pattern){
+        return dynamic_cast<VarNode*>(pattern);
+    }
+
+    /**
+     * Returns true if the match can be compiled to a single switch over
+     * the union tag or integer being matched.  This is the case when every
+     * branch's pattern is a union variant or an integer literal, except
+     * for an optional catch-all as the last branch.
+     */
+    bool canMatchWithSwitch(MatchNode *n, TypedValue &valToMatch){
+        if(n->branches.size() < 2)
+            return false;
+
+        Type *ty = valToMatch.getType();
+        bool isUnion = valToMatch.type->typeTag == TT_TaggedUnion and (ty->isStructTy() or ty->isIntegerTy());
+
+        for(auto &mbn : n->branches){
+            Node *pattern = mbn->pattern.get();
+            Node *bindExpr;
+
+            if(isCatchAllPattern(pattern)){
+                if(&mbn != &n->branches.back())
+                    return false;
+            }else if(getVariantPattern(pattern, bindExpr)){
+                if(!isUnion) return false;
+            }else if(dynamic_cast<IntLitNode*>(pattern)){
+                if(!ty->isIntegerTy()) return false;
+            }else{
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Compiles the body of a branch whose pattern has already matched
+     * and jumps to endmatch afterward.
+     */
+    void compileBranchBody(CompilingVisitor &cv, MatchBranchNode *mbn, BasicBlock *endmatch,
+            vector<pair<BasicBlock*,TypedValue>> &merges){
+
+        mbn->branch->accept(cv);
+        merges.push_back({cv.c->builder.GetInsertBlock(), cv.val});
+
+        //dont jump to after the match if the branch already returned from the function
+        if(!dyn_cast<ReturnInst>(cv.val.val))
+            cv.c->builder.CreateBr(endmatch);
+    }
+
+    /**
+     * Compiles the block a switch jumps to when no case matches, which
+     * is either the final catch-all branch or a jump to endmatch.
+     * Leaves the insert point at endmatch.
+     */
+    void compileDefaultBranch(CompilingVisitor &cv, MatchNode *n, BasicBlock *defaultBB, bool hasCatchAll,
+            TypedValue &valToMatch, BasicBlock *endmatch, vector<pair<BasicBlock*,TypedValue>> &merges){
+
+        Compiler *c = cv.c;
+        c->builder.SetInsertPoint(defaultBB);
+
+        if(hasCatchAll){
+            auto &mbn = n->branches.back();
+            c->enterNewScope();
+            handlePattern(cv, n, mbn->pattern.get(), endmatch, valToMatch);
+            compileBranchBody(cv, mbn.get(), endmatch, merges);
+            c->exitScope();
+        }else{
+            // Cannot prove to LLVM match is exhaustive so an uninitialized value must be
+            // "returned" each time from the branch where all matches fail.
+            TypedValue retOnFailAll = {UndefValue::get(cv.val.getType()), cv.val.type};
+            merges.push_back({defaultBB, retOnFailAll});
+            c->builder.CreateBr(endmatch);
+        }
+
+        c->builder.SetInsertPoint(endmatch);
+    }
+
+    /**
+     * Compiles each branch with a single switch to the first branch whose
+     * pattern could match.  Branches sharing the same tag or integer are
+     * chained together so that if a nested pattern fails the next branch
+     * with the same tag is tried, followed by the catch-all if any.
+     */
+    void compileMatchAsSwitch(CompilingVisitor &cv, MatchNode *n, TypedValue &valToMatch,
+            BasicBlock *endmatch, vector<pair<BasicBlock*,TypedValue>> &merges){
+
+        Compiler *c = cv.c;
+        Function *f = getCurFunction(c);
+
+        bool hasCatchAll = isCatchAllPattern(n->branches.back()->pattern.get());
+        size_t numCases = hasCatchAll ? n->branches.size() - 1 : n->branches.size();
+
+        Value *switchVal = valToMatch.type->typeTag == TT_TaggedUnion ? getUnionTag(c, valToMatch) : valToMatch.val;
+
+        //The key of each branch and the tag type of each variant pattern
+        //must be found before the switch is created
+        vector<ConstantInt*> keys;
+        vector<AnDataType*> tagTys;
+        for(size_t i = 0; i < numCases; i++){
+            Node *pattern = n->branches[i]->pattern.get();
+            Node *bindExpr;
+
+            if(TypeNode *variant = getVariantPattern(pattern, bindExpr)){
+                tagTys.push_back(getVariantPatternType(c, variant, valToMatch));
+                keys.push_back(ConstantInt::get((IntegerType*)switchVal->getType(), getVariantTag(variant)));
+            }else{
+                pattern->accept(cv);
+                if(!c->typeEq(cv.val.type, valToMatch.type)){
+                    c->compErr("Cannot match pattern of type " + anTypeToColoredStr(cv.val.type)
+                            + " to corresponding value's type " + anTypeToColoredStr(valToMatch.type), pattern->loc);
+                }
+                tagTys.push_back(nullptr);
+                keys.push_back(cast<ConstantInt>(cv.val.val));
+            }
+        }
+
+        BasicBlock *defaultBB = BasicBlock::Create(*c->ctxt, hasCatchAll ? "match_default" : "match_fail", f);
+        auto *sw = c->builder.CreateSwitch(switchVal, defaultBB, numCases);
+
+        vector<BasicBlock*> caseBBs;
+        for(size_t i = 0; i < numCases; i++)
+            caseBBs.push_back(BasicBlock::Create(*c->ctxt, "match_case", f));
+
+        //Only the first branch of each key is jumped to by the switch itself
+        SmallPtrSet<ConstantInt*, 16> addedKeys;
+        for(size_t i = 0; i < numCases; i++){
+            if(addedKeys.insert(keys[i]).second)
+                sw->addCase(keys[i], caseBBs[i]);
+        }
+
+        for(size_t i = 0; i < numCases; i++){
+            auto &mbn = n->branches[i];
+
+            BasicBlock *jmpOnFail = defaultBB;
+            for(size_t j = i + 1; j < numCases; j++){
+                if(keys[j] == keys[i]){
+                    jmpOnFail = caseBBs[j];
+                    break;
+                }
+            }
+
+            c->builder.SetInsertPoint(caseBBs[i]);
+            c->enterNewScope();
+
+            Node *bindExpr;
+            if(tagTys[i] and getVariantPattern(mbn->pattern.get(), bindExpr) and bindExpr)
+                bind_variant(cv, n, tagTys[i], bindExpr, jmpOnFail, valToMatch);
+
+            compileBranchBody(cv, mbn.get(), endmatch, merges);
+            c->exitScope();
+        }
+
+        compileDefaultBranch(cv, n, defaultBB, hasCatchAll, valToMatch, endmatch, merges);
+    }
+
+
+    /**
+     * Emits a test of whether cStr, a string of length strs[0]->size(), equals one
+     * of the given literals, all of the same length, and jumps to the corresponding
+     * element of caseBBs if so or to defaultBB otherwise.
+     *
+     * Each character position distinguishing the literals is switched on in turn
+     * so that only a single comparison of the whole string is ever needed.
+     */
+    void dispatchOnChars(Compiler *c, Value *cStr, vector<string const*> &strs,
+            vector<BasicBlock*> &caseBBs, BasicBlock *defaultBB){
+
+        Function *f = getCurFunction(c);
+        size_t len = strs[0]->size();
+
+        if(strs.size() == 1){
+            BasicBlock *jmpOnSuccess = caseBBs[0];
+            if(len == 0){
+                c->builder.CreateBr(jmpOnSuccess);
+                return;
+            }
+
+            auto *usz = cast<IntegerType>(c->anTypeToLlvmType(AnType::getUsz()));
+            auto *i8ptr = c->builder.getInt8PtrTy();
+            auto *memcmpFn = c->module->getOrInsertFunction("memcmp",
+                    FunctionType::get(c->builder.getInt32Ty(), {i8ptr, i8ptr, usz}, false));
+
+            auto *lit = c->builder.CreateGlobalStringPtr(*strs[0], "_strlit");
+            auto *cmp = c->builder.CreateCall(memcmpFn, {cStr, lit, ConstantInt::get(usz, len)});
+            auto *eq = c->builder.CreateICmpEQ(cmp, c->builder.getInt32(0));
+            c->builder.CreateCondBr(eq, jmpOnSuccess, defaultBB);
+            return;
+        }
+
+        //Find the position with the most distinct characters among strs
+        size_t bestPos = 0, mostDistinct = 0;
+        for(size_t pos = 0; pos < len; pos++){
+            SmallSet<char, 16> chars;
+            for(auto *str : strs)
+                chars.insert((*str)[pos]);
+
+            if(chars.size() > mostDistinct){
+                mostDistinct = chars.size();
+                bestPos = pos;
+            }
+        }
+
+        auto *charPtr = c->builder.CreateConstInBoundsGEP1_64(cStr, bestPos);
+        auto *sw = c->builder.CreateSwitch(c->builder.CreateLoad(charPtr), defaultBB, mostDistinct);
+
+        //group the literals by their character at bestPos, keeping their order
+        vector<char> groupChars;
+        vector<vector<string const*>> groupStrs;
+        vector<vector<BasicBlock*>> groupBBs;
+        for(size_t i = 0; i < strs.size(); i++){
+            char ch = (*strs[i])[bestPos];
+            size_t g = find(groupChars.begin(), groupChars.end(), ch) - groupChars.begin();
+            if(g == groupChars.size()){
+                groupChars.push_back(ch);
+                groupStrs.emplace_back();
+                groupBBs.emplace_back();
+            }
+            groupStrs[g].push_back(strs[i]);
+            groupBBs[g].push_back(caseBBs[i]);
+        }
+
+        for(size_t g = 0; g < groupChars.size(); g++){
+            BasicBlock *bb = BasicBlock::Create(*c->ctxt, "match_char", f);
+            sw->addCase(c->builder.getInt8(groupChars[g]), bb);
+            c->builder.SetInsertPoint(bb);
+            dispatchOnChars(c, cStr, groupStrs[g], groupBBs[g], defaultBB);
+        }
+    }
+
+
+    /**
+     * Returns true if the match can be compiled as a switch over the length
+     * of a Str followed by a switch over its characters.  This is the case
+     * when every branch's pattern is a string literal, except for an optional
+     * catch-all as the last branch.
+     */
+    bool canMatchStrWithSwitch(MatchNode *n, TypedValue &valToMatch){
+        if(n->branches.size() < 2 or valToMatch.type->typeTag != TT_Data
+                or ((AnDataType*)valToMatch.type)->name != "Str")
+            return false;
+
+        for(auto &mbn : n->branches){
+            Node *pattern = mbn->pattern.get();
+
+            if(isCatchAllPattern(pattern)){
+                if(&mbn != &n->branches.back())
+                    return false;
+            }else if(StrLitNode *sln = dynamic_cast<StrLitNode*>(pattern)){
+                //interpolated strings are not constant
+                if(sln->val.find("${") != string::npos)
+                    return false;
+            }else{
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Compiles a match on string literals with a switch on the length of
+     * the string followed by a switch on the characters distinguishing the
+     * literals of that length.  The single remaining candidate is confirmed
+     * with a memcmp.
+     */
+    void compileStrMatchAsSwitch(CompilingVisitor &cv, MatchNode *n, TypedValue &valToMatch,
+            BasicBlock *endmatch, vector<pair<BasicBlock*,TypedValue>> &merges){
+
+        Compiler *c = cv.c;
+        Function *f = getCurFunction(c);
+
+        bool hasCatchAll = isCatchAllPattern(n->branches.back()->pattern.get());
+        size_t numCases = hasCatchAll ? n->branches.size() - 1 : n->branches.size();
+
+        Value *cStr = c->builder.CreateExtractValue(valToMatch.val, 0);
+        Value *len = c->builder.CreateExtractValue(valToMatch.val, 1);
+
+        BasicBlock *defaultBB = BasicBlock::Create(*c->ctxt, hasCatchAll ? "match_default" : "match_fail", f);
+        auto *sw = c->builder.CreateSwitch(len, defaultBB);
+
+        vector<BasicBlock*> caseBBs;
+        for(size_t i = 0; i < numCases; i++)
+            caseBBs.push_back(BasicBlock::Create(*c->ctxt, "match_case", f));
+
+        //group the literals by length, ignoring any repeated literal as
+        //only its first branch can ever be matched
+        vector<size_t> groupLens;
+        vector<vector<string const*>> groupStrs;
+        vector<vector<BasicBlock*>> groupBBs;
+        for(size_t i = 0; i < numCases; i++){
+            string const& str = ((StrLitNode*)n->branches[i]->pattern.get())->val;
+
+            size_t g = find(groupLens.begin(), groupLens.end(), str.size()) - groupLens.begin();
+            if(g == groupLens.size()){
+                groupLens.push_back(str.size());
+                groupStrs.emplace_back();
+                groupBBs.emplace_back();
+            }
+
+            bool isRepeat = false;
+            for(auto *prev : groupStrs[g])
+                isRepeat = isRepeat or *prev == str;
+
+            if(!isRepeat){
+                groupStrs[g].push_back(&str);
+                groupBBs[g].push_back(caseBBs[i]);
+            }
+        }
+
+        for(size_t g = 0; g < groupLens.size(); g++){
+            BasicBlock *bb = BasicBlock::Create(*c->ctxt, "match_len", f);
+            sw->addCase(ConstantInt::get(cast<IntegerType>(len->getType()), groupLens[g]), bb);
+            c->builder.SetInsertPoint(bb);
+            dispatchOnChars(c, cStr, groupStrs[g], groupBBs[g], defaultBB);
+        }
+
+        for(size_t i = 0; i < numCases; i++){
+            c->builder.SetInsertPoint(caseBBs[i]);
+            c->enterNewScope();
+            compileBranchBody(cv, n->branches[i].get(), endmatch, merges);
+            c->exitScope();
+        }
+
+        compileDefaultBranch(cv, n, defaultBB, hasCatchAll, valToMatch, endmatch, merges);
+    }
+
+
     void CompilingVisitor::visit(MatchNode *n){
         n->expr->accept(*this);
         auto valToMatch = this->val;
@@ -229,34 +617,41 @@ namespace ante {
         Function *f = c->builder.GetInsertBlock()->getParent();
 
         vector<pair<BasicBlock*,TypedValue>> merges;
-        merges.reserve(n->branches.size());
+        merges.reserve(n->branches.size() + 1);
 
         BasicBlock *endmatch = BasicBlock::Create(*c->ctxt, "end_match", f);
-        BasicBlock *finalEndPat = nullptr;
 
-        for(auto& mbn : n->branches){
-            BasicBlock *endpat = &mbn == &n->branches.back() ?
-                endmatch : BasicBlock::Create(*c->ctxt, "end_pattern", f);
+        if(canMatchWithSwitch(n, valToMatch)){
+            compileMatchAsSwitch(*this, n, valToMatch, endmatch, merges);
+        }else if(canMatchStrWithSwitch(n, valToMatch)){
+            compileStrMatchAsSwitch(*this, n, valToMatch, endmatch, merges);
+        }else{
+            BasicBlock *finalEndPat = nullptr;
 
-            c->enterNewScope();
-            handlePattern(*this, n, mbn->pattern.get(), endpat, valToMatch);
-            mbn->branch->accept(*this);
-            merges.push_back({c->builder.GetInsertBlock(), this->val});
+            for(auto& mbn : n->branches){
+                BasicBlock *endpat = &mbn == &n->branches.back() ?
+                    endmatch : BasicBlock::Create(*c->ctxt, "end_pattern", f);
 
-            //dont jump to after the match if the branch already returned from the function
-            if(!dyn_cast<ReturnInst>(this->val.val))
-                c->builder.CreateBr(endmatch);
+                c->enterNewScope();
+                handlePattern(*this, n, mbn->pattern.get(), endpat, valToMatch);
+                mbn->branch->accept(*this);
+                merges.push_back({c->builder.GetInsertBlock(), this->val});
 
-            c->builder.SetInsertPoint(endpat); //set insert point to next branch
-            finalEndPat = endpat == endmatch ? finalEndPat : endpat;
-            c->exitScope();
-        }
+                //dont jump to after the match if the branch already returned from the function
+                if(!dyn_cast<ReturnInst>(this->val.val))
+                    c->builder.CreateBr(endmatch);
 
-        // Cannot prove to LLVM match is exhaustive so an uninitialized value must be
-        // "returned" each time from the branch where all matches fail.
-        if(finalEndPat){
-            TypedValue retOnFailAll = {UndefValue::get(this->val.getType()), val.type};
-            merges.push_back({finalEndPat, retOnFailAll});
+                c->builder.SetInsertPoint(endpat); //set insert point to next branch
+                finalEndPat = endpat == endmatch ? finalEndPat : endpat;
+                c->exitScope();
+            }
+
+            // Cannot prove to LLVM match is exhaustive so an uninitialized value must be
+            // "returned" each time from the branch where all matches fail.
+            if(finalEndPat){
+                TypedValue retOnFailAll = {UndefValue::get(this->val.getType()), val.type};
+                merges.push_back({finalEndPat, retOnFailAll});
+            }
         }
 
         //merges can be empty if each branch has an early return
@@ -408,6 +408,7 @@ namespace ante {
 
         try{
             //compMetaFunctionResult(c, fake_loc, "print", mangledName, {tv});
+            //anything printed is written out once the call returns, before the next prompt
             compMetaFunctionResult(c, fake_loc, name, mangledName, {tv});
         }catch(CompilationError *err){
             //fall back on naive dumping of llvm value
@@ -140,6 +140,21 @@ Result<size_t, string> AnType::getSizeInBits(Compiler *c, string *incompleteType
             return "Type " + anTypeToStr(this) + " has not been declared\n";
         }
 
+        if(typeTag == TT_TaggedUnion){
+            switch(getUnionLayout(dataTy)){
+                case UnionLayout::Bool: return 8;
+                case UnionLayout::Tagged: break;
+            }
+
+            //each ext is a tuple of the tag and variant so the largest is the union's size
+            for(auto *ext : dataTy->extTys){
+                auto val = ext->getSizeInBits(c, incompleteType, force);
+                if(!val) return val;
+                total = max(total, val.getVal());
+            }
+            return total;
+        }
+
         for(auto *ext : dataTy->extTys){
             auto val = ext->getSizeInBits(c, incompleteType, force);
             if(!val) return val;
@@ -245,6 +260,15 @@ Type* updateLlvmTypeBinding(Compiler *c, AnDataType *dt, bool force){
         //return nullptr;
     }
 
+    //unions with a niche layout are just their only non-empty variant
+    if(dt->typeTag == TT_TaggedUnion){
+        auto layout = getUnionLayout(dt);
+        if(layout == UnionLayout::Bool){
+            structTy->setBody({Type::getInt8Ty(*c->ctxt)}, isPacked);
+            return structTy;
+        }
+    }
+
     AnType *ext = dt;
     if(dt->typeTag == TT_TaggedUnion)
         ext = getLargestExt(c, dt, force);
@@ -575,6 +599,134 @@ AnType* getLargestExt(Compiler *c, AnDataType *tn, bool force){
 
 
 
+AnType* getUnionPayloadType(const AnDataType *unionTy, unsigned short tag){
+    //each of a union's extTys is a tuple of its tag and the variant's contents
+    auto *variant = (AnAggregateType*)unionTy->extTys[tag];
+    return variant->extTys[1];
+}
+
+
+UnionLayout getUnionLayout(const AnDataType *unionTy){
+    if(unionTy->typeTag != TT_TaggedUnion or unionTy->extTys.size() != 2)
+        return UnionLayout::Tagged;
+
+    AnType *first = getUnionPayloadType(unionTy, 0);
+    AnType *second = getUnionPayloadType(unionTy, 1);
+
+    AnType *payload;
+    if(first->typeTag == TT_Void)
+        payload = second;
+    else if(second->typeTag == TT_Void)
+        payload = first;
+    else
+        return UnionLayout::Tagged;
+
+    if(payload->typeTag == TT_Bool)
+        return UnionLayout::Bool;
+    return UnionLayout::Tagged;
+}
+
+
+unsigned short getNicheEmptyTag(const AnDataType *unionTy){
+    return getUnionPayloadType(unionTy, 0)->typeTag == TT_Void ? 0 : 1;
+}
+
+
+Type* getUnionTagType(Compiler *c, const AnDataType *unionTy){
+    if(getUnionLayout(unionTy) != UnionLayout::Tagged or unionTy->extTys.empty())
+        return Type::getInt8Ty(*c->ctxt);
+
+    auto *variant = (AnAggregateType*)unionTy->extTys[0];
+    return c->anTypeToLlvmType(variant->extTys[0]);
+}
+
+
+Value* extractUnionTag(Compiler *c, TypedValue const& unionVal){
+    auto *unionTy = (AnDataType*)unionVal.type;
+    auto layout = getUnionLayout(unionTy);
+
+    if(layout != UnionLayout::Tagged){
+        auto *tagTy = Type::getInt8Ty(*c->ctxt);
+        auto *emptyTag = ConstantInt::get(tagTy, getNicheEmptyTag(unionTy));
+        auto *payloadTag = ConstantInt::get(tagTy, 1 - getNicheEmptyTag(unionTy));
+
+        Value *field = c->builder.CreateExtractValue(unionVal.val, 0);
+        Value *isEmpty = c->builder.CreateICmpEQ(field, c->builder.getInt8(2));
+
+        return c->builder.CreateSelect(isEmpty, emptyTag, payloadTag);
+    }
+
+    //all tagged unions are either just their tag (enum) or a tag and value.
+    if(unionVal.getType()->isStructTy())
+        return c->builder.CreateExtractValue(unionVal.val, 0);
+    return unionVal.val;
+}
+
+
+TypedValue createUnionValue(Compiler *c, AnDataType *unionTy, unsigned short tag,
+        TypedValue const& payload, bool force){
+
+    Type *unionLlvmTy = c->anTypeToLlvmType(unionTy, force);
+    auto layout = getUnionLayout(unionTy);
+
+    if(layout == UnionLayout::Bool){
+        Value *b = tag == getNicheEmptyTag(unionTy)
+            ? c->builder.getInt8(2)
+            : c->builder.CreateZExt(payload.val, c->builder.getInt8Ty());
+
+        return {c->builder.CreateInsertValue(UndefValue::get(unionLlvmTy), b, 0), unionTy};
+    }
+
+    Type *tagTy = getUnionTagType(c, unionTy);
+    Value *variant = ConstantInt::get(tagTy, tag);
+
+    //create a struct of (tag, <union member type>)
+    if(payload.type->typeTag != TT_Void){
+        auto *variantTy = StructType::get(*c->ctxt, {tagTy, payload.getType()}, true);
+        variant = c->builder.CreateInsertValue(UndefValue::get(variantTy), variant, 0);
+        variant = c->builder.CreateInsertValue(variant, payload.val, 1);
+    }
+
+    //allocate for the largest possible union member
+    auto *alloca = c->builder.CreateAlloca(unionLlvmTy);
+
+    //but bitcast it the the current member
+    auto *castTo = c->builder.CreateBitCast(alloca, variant->getType()->getPointerTo());
+    c->builder.CreateStore(variant, castTo);
+
+    //load the original alloca, not the bitcasted one
+    return {c->builder.CreateLoad(alloca), unionTy};
+}
+
+
+Value* loadAsType(Compiler *c, Value *alloca, AnType *ty){
+    auto *unionTy = dyn_cast<AnDataType>(ty);
+    if(!unionTy or getUnionLayout(unionTy) == UnionLayout::Tagged){
+        auto *cast = c->builder.CreateBitCast(alloca, c->anTypeToLlvmType(ty)->getPointerTo());
+        return c->builder.CreateLoad(cast);
+    }
+
+    //Before being bound the union could not have had a niche layout, so its tag
+    //is stored first, followed by the contents of its variant.
+    auto *tagTy = c->builder.getInt8Ty();
+    unsigned short emptyTag = getNicheEmptyTag(unionTy);
+    unsigned short payloadTag = 1 - emptyTag;
+
+    auto *tag = c->builder.CreateLoad(c->builder.CreateBitCast(alloca, tagTy->getPointerTo()));
+
+    AnType *payloadTy = getUnionPayloadType(unionTy, payloadTag);
+    auto *variantTy = StructType::get(*c->ctxt, {tagTy, c->anTypeToLlvmType(payloadTy)}, true);
+    auto *variantPtr = c->builder.CreateBitCast(alloca, variantTy->getPointerTo());
+    auto *payload = c->builder.CreateLoad(c->builder.CreateStructGEP(variantTy, variantPtr, 1));
+
+    auto empty = createUnionValue(c, unionTy, emptyTag, c->getVoidLiteral());
+    auto full = createUnionValue(c, unionTy, payloadTag, {payload, payloadTy});
+
+    auto *isEmpty = c->builder.CreateICmpEQ(tag, ConstantInt::get(tagTy, emptyTag));
+    return c->builder.CreateSelect(isEmpty, empty.val, full.val);
+}
+
+
 /*
  *  Translates a llvm::Type to a TypeTag. Not intended for in-depth analysis
  *  as it loses data about the type and name of UserTypes, and cannot distinguish